@@ -0,0 +1,626 @@
+/*
+	Title:    benchmark_driver.cpp
+	Purpose:  To benchmark the four algorithm programs with the same timers, counters and output
+*/
+#include "instrumentation.h"
+#include "../Mapped-File/mapped_file.h"
+
+// Every header the programs include. They are included here, outside of the namespaces below,
+// so the include guards make the same includes inside the namespaces do nothing.
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <cctype>
+#include <cerrno>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Each program is compiled into a namespace of its own, with its main renamed, so their
+// functions are called directly and their helpers with the same names do not collide.
+namespace hull {
+#define main hull_main
+#include "../Brute-Force-Convex-Hull/kwfarkas42.cpp"
+#undef main
+}
+
+namespace topo {
+#define main topo_main
+#include "../Decrease-and-Conquer-Topological-Sort/kwfarkas42.cpp"
+#undef main
+}
+
+namespace unmerge {
+#define main unmerge_main
+#include "../Unmerge-Sort/kwfarkas42.cpp"
+#undef main
+}
+
+namespace euclid {
+#define main euclid_main
+#include "../Euclids-Algorithm/kwfarkas42.cpp"
+#undef main
+}
+
+/* Prints instructions for using the program.
+ *
+ * @param name - the name of the program
+ * */
+void usage(char *name);
+
+/* Driver options.
+ *
+ * The options every benchmark runs with: the largest size of the sweeps, the number of timed
+ * repetitions, the number of threads of the engines that use them, the report format and the
+ * programs to benchmark.
+ * */
+struct driver_options {
+	std::size_t max_n;
+	unsigned n_reps;
+	unsigned n_threads;
+	report_format format;
+	std::vector<std::string> programs;
+};
+
+/* Report being written.
+ *
+ * The stream and format of the report and the number of records written to it so far.
+ * */
+struct report_state {
+	std::ostream &os;
+	report_format format;
+	std::size_t n_records;
+};
+
+/* Silences std::cout.
+ *
+ * Discards everything written to std::cout while the object exists, so the programs' own
+ * prints, such as the "Elapsed Time" of get_topological_sorting and the result line of
+ * calculate_gcd, are still formatted but never reach the report.
+ * */
+class cout_silencer {
+public:
+	cout_silencer() : saved(std::cout.rdbuf(&discard)) {}
+	~cout_silencer() { std::cout.rdbuf(saved); }
+
+private:
+	cout_silencer(const cout_silencer &);
+	cout_silencer & operator=(const cout_silencer &);
+
+	struct discard_buffer : std::streambuf {
+		int overflow(int c) { return traits_type::not_eof(c); }
+		std::streamsize xsputn(const char *, std::streamsize n) { return n; }
+	};
+
+	discard_buffer discard;
+	std::streambuf *saved;
+};
+
+/* Timed run.
+ *
+ * One repetition of a benchmark case, which times its phases in the profile it is given.
+ * */
+typedef std::function<void(phase_profile &profile)> timed_run;
+
+/* Benchmark case setup.
+ *
+ * Builds the input of a benchmark case, which is not timed, and returns the timed_run that
+ * runs the case on it.
+ * */
+typedef std::function<timed_run()> case_setup;
+
+/* Runs a benchmark case.
+ *
+ * This function forks a child process that calls setup, opens the perf_counters, runs the
+ * timed_run once to warm up the caches and the allocator and then n_reps more times with a
+ * fresh phase_profile each. The phases are summarized with summarize_phases, with the peak
+ * resident set size of the child, and sent back through a pipe to be written to the report.
+ * As the input is only built in the child, the peak resident set size of each case is its
+ * own. A case that fails is reported on std::cerr and skipped.
+ *
+ * @param report - the report the records are written to
+ * @param base - the program, engine, input and n of the case
+ * @param n_reps - the number of timed repetitions
+ * @param setup - builds the input and returns the timed_run
+ *
+ * @throws std::runtime_error - thrown if the pipe or the child process cannot be created
+ * */
+void run_case(report_state &report, const benchmark_record &base, unsigned n_reps, const case_setup &setup);
+
+/* Benchmarks find_hull.
+ *
+ * Every hull_algorithm runs on points from every point_distribution for n = 100, 1000, ...
+ * up to max_n, the brute force algorithm only up to 1000 points, with a single find_hull
+ * phase.
+ *
+ * @param report - the report the records are written to
+ * @param options - the options of the driver
+ * */
+void benchmark_hull(report_state &report, const driver_options &options);
+
+/* Benchmarks get_topological_sorting.
+ *
+ * Every engine sorts a DAG of every dag_family with n = 1000, 10000, ... up to max_n
+ * vertices, the matrix engine only up to 4096 vertices and the bit matrix engine up to
+ * 16384. The DAG is written to a temporary file that read_csr_graph reads in a read phase,
+ * which is also broken down into the parse, dedup, relabel and build phases read_csr_graph
+ * times itself, and get_topological_sorting is timed in a sort phase.
+ *
+ * @param report - the report the records are written to
+ * @param options - the options of the driver
+ * */
+void benchmark_topological_sort(report_state &report, const driver_options &options);
+
+/* Benchmarks unmerge_sort and merge_sort.
+ *
+ * For n = 1000, 10000, ... up to max_n, both unmerge engines build the worst case of 0 to n-1
+ * in an unmerge phase, and every merge engine sorts that worst case in a sort phase.
+ *
+ * @param report - the report the records are written to
+ * @param options - the options of the driver
+ * */
+void benchmark_merge_sort(report_state &report, const driver_options &options);
+
+/* Benchmarks calculate_gcd.
+ *
+ * For n = 1000, 10000, ... up to max_n random pairs of ints, calculate_gcd is called on
+ * every pair with std::cout silenced, and the same pairs are run through the templated gcd
+ * and through gcd_batch, each in a single gcd phase.
+ *
+ * @param report - the report the records are written to
+ * @param options - the options of the driver
+ * */
+void benchmark_gcd(report_state &report, const driver_options &options);
+
+
+
+
+
+
+void usage(char *name) {
+	std::cout << "Benchmarks the convex hull, topological sort, merge sort and gcd programs" << std::endl;
+	std::cout << "usage: " << name << " [--format=csv|json] [--reps=n] [--max-n=n] [--threads=n]"
+		<< " [--programs=list]" << std::endl;
+	std::cout << "  --format - format of the report (default: csv)" << std::endl;
+	std::cout << "  --reps - number of timed runs per benchmark (default: 7)" << std::endl;
+	std::cout << "  --max-n - largest input size of the sweeps (default: 1000000)" << std::endl;
+	std::cout << "  --threads - number of threads of the engines that use them (default: 1)" << std::endl;
+	std::cout << "  --programs - comma separated programs to benchmark out of hull, topo, merge and gcd"
+		<< " (default: all)" << std::endl;
+	std::cout << "Each phase of each run is one record with its median and p99 time, the median" << std::endl;
+	std::cout << "cycles, cache misses and branch misses when perf_event_open allows them, and the" << std::endl;
+	std::cout << "peak resident set size." << std::endl;
+}
+
+void run_case(report_state &report, const benchmark_record &base, unsigned n_reps, const case_setup &setup) {
+	int fds[2];
+	if(pipe(fds) != 0) {
+		std::ostringstream oss;
+		oss << "pipe: " << std::strerror(errno);
+		throw std::runtime_error(oss.str());
+	}
+	// the child must not print what is still buffered here a second time
+	report.os.flush();
+	std::cout.flush();
+	pid_t pid = fork();
+	if(pid < 0) {
+		std::ostringstream oss;
+		oss << "fork: " << std::strerror(errno);
+		close(fds[0]);
+		close(fds[1]);
+		throw std::runtime_error(oss.str());
+	}
+	if(pid == 0) {
+		close(fds[0]);
+		try {
+			timed_run run = setup();
+			perf_counters counters;
+			std::vector<phase_profile> profiles;
+			for(unsigned rep = 0; rep <= n_reps; rep++) {
+				phase_profile profile(&counters);
+				run(profile);
+				// the first run only warms up the caches and the allocator
+				if(rep > 0)
+					profiles.push_back(profile);
+			}
+
+			benchmark_record record = base;
+			std::vector<benchmark_record> records;
+			record.peak_rss_kb = peak_rss_kb();
+			summarize_phases(record, profiles, records);
+
+			std::ostringstream oss;
+			for(std::size_t i = 0; i < records.size(); i++) {
+				write_report_record(oss, report.format, records[i], report.n_records + i == 0);
+			}
+			std::string text = oss.str();
+			for(std::size_t written = 0; written < text.size();) {
+				ssize_t n_written = write(fds[1], text.data() + written, text.size() - written);
+				if(n_written < 0 && errno == EINTR)
+					continue;
+				if(n_written < 0)
+					_exit(1);
+				written += n_written;
+			}
+		}
+		catch (std::exception &ex) {
+			std::cerr << ex.what() << std::endl;
+			_exit(1);
+		}
+		_exit(0);
+	}
+
+	close(fds[1]);
+	std::string text;
+	char buffer[4096];
+	for(;;) {
+		ssize_t n_read = read(fds[0], buffer, sizeof(buffer));
+		if(n_read < 0 && errno == EINTR)
+			continue;
+		if(n_read <= 0)
+			break;
+		text.append(buffer, n_read);
+	}
+	close(fds[0]);
+	int status;
+	waitpid(pid, &status, 0);
+	if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		std::cerr << base.program << "," << base.engine << "," << base.input << "," << base.n
+			<< ": benchmark failed" << std::endl;
+		return;
+	}
+
+	// every record is one line
+	report.os << text;
+	report.n_records += std::count(text.begin(), text.end(), '\n');
+}
+
+void benchmark_hull(report_state &report, const driver_options &options) {
+	const hull::point_distribution dists[] = {hull::UNIFORM_SQUARE, hull::UNIFORM_DISK, hull::ON_CIRCLE, hull::GAUSSIAN};
+	const hull::hull_algorithm algorithms[] = {hull::BRUTE_FORCE, hull::MONOTONE_CHAIN, hull::GRAHAM_SCAN,
+		hull::QUICKHULL, hull::INCREMENTAL};
+	const std::size_t max_brute_n = 1000;
+	unsigned n_threads = options.n_threads;
+
+	for(hull::point_distribution dist : dists) {
+		for(std::size_t n = 100; n <= options.max_n; n *= 10) {
+			for(hull::hull_algorithm algorithm : algorithms) {
+				if(algorithm == hull::BRUTE_FORCE && n > max_brute_n)
+					continue;
+
+				benchmark_record base = benchmark_record();
+				base.program = "find_hull";
+				base.engine = hull::algorithm_name(algorithm);
+				base.input = hull::distribution_name(dist);
+				base.n = n;
+				run_case(report, base, options.n_reps, [=]() {
+					// every algorithm sees the same points
+					std::mt19937_64 rng(n);
+					std::shared_ptr<std::vector<hull::point>> pts(new std::vector<hull::point>());
+					hull::generate_points(dist, n, rng, *pts);
+
+					return timed_run([=](phase_profile &profile) {
+						std::vector<hull::point> hull_pts;
+						scoped_phase phase(profile, "find_hull");
+						hull::find_hull(*pts, hull_pts, algorithm, 0, n_threads);
+					});
+				});
+			}
+		}
+	}
+}
+
+void benchmark_topological_sort(report_state &report, const driver_options &options) {
+	const topo::dag_family families[] = {topo::DAG_GNP, topo::DAG_CHAIN, topo::DAG_LAYERED, topo::DAG_POWER_LAW};
+	const topo::sort_engine engines[] = {topo::ENGINE_MATRIX, topo::ENGINE_BIT_MATRIX, topo::ENGINE_KAHN,
+		topo::ENGINE_PARALLEL};
+	const std::size_t max_matrix_n = 4096, max_bit_matrix_n = 16384;
+	const unsigned degree = 8;
+	unsigned n_threads = options.n_threads;
+
+	const char *tmpdir = std::getenv("TMPDIR");
+	std::string filename = std::string(tmpdir ? tmpdir : "/tmp") + "/benchmark-driver-XXXXXX";
+	int fd = mkstemp(&filename[0]);
+	if(fd < 0) {
+		std::ostringstream oss;
+		oss << filename << ": " << std::strerror(errno);
+		throw std::runtime_error(oss.str());
+	}
+	close(fd);
+
+	try {
+		for(topo::dag_family family : families) {
+			for(std::size_t n = 1000; n <= options.max_n; n *= 10) {
+				// every engine sees the same graph
+				std::mt19937_64 rng(n);
+				std::ofstream ofs(filename.c_str());
+				topo::generate_dag(family, n, degree, rng, ofs);
+				ofs.close();
+				if(ofs.fail()) {
+					std::ostringstream oss;
+					oss << filename << ": " << std::strerror(errno);
+					throw std::runtime_error(oss.str());
+				}
+
+				for(topo::sort_engine engine : engines) {
+					if((engine == topo::ENGINE_MATRIX && n > max_matrix_n)
+						|| (engine == topo::ENGINE_BIT_MATRIX && n > max_bit_matrix_n))
+						continue;
+
+					benchmark_record base = benchmark_record();
+					base.program = "get_topological_sorting";
+					base.engine = topo::engine_name(engine);
+					base.input = topo::dag_family_name(family);
+					base.n = n;
+					run_case(report, base, options.n_reps, [=]() {
+						return timed_run([=](phase_profile &profile) {
+							topo::csr_graph graph;
+							std::vector<topo::vertex_t> labels;
+							topo::read_phase_times read_times;
+							{
+								scoped_phase phase(profile, "read");
+								topo::read_csr_graph(filename, graph, labels, n_threads, 0, &read_times);
+							}
+							profile.add("parse", read_times.parse_us);
+							profile.add("dedup", read_times.dedup_us);
+							profile.add("relabel", read_times.relabel_us);
+							profile.add("build", read_times.build_us);
+
+							cout_silencer silence;
+							scoped_phase phase(profile, "sort");
+							topo::get_topological_sorting(graph, labels, engine, n_threads);
+						});
+					});
+				}
+			}
+		}
+	}
+	catch (...) {
+		unlink(filename.c_str());
+		throw;
+	}
+	unlink(filename.c_str());
+}
+
+void benchmark_merge_sort(report_state &report, const driver_options &options) {
+	const char *unmerge_engines[] = {"classic", "direct"};
+	const char *merge_engines[] = {"classic", "buffered", "parallel", "generic", "kernel"};
+	unsigned n_threads = options.n_threads;
+
+	for(std::size_t n = 1000; n <= options.max_n; n *= 10) {
+		for(const char *name : unmerge_engines) {
+			unmerge::unmerge_engine engine = unmerge::parse_unmerge_engine(name);
+
+			benchmark_record base = benchmark_record();
+			base.program = "unmerge_sort";
+			base.engine = name;
+			base.input = "sorted";
+			base.n = n;
+			run_case(report, base, options.n_reps, [=]() {
+				return timed_run([=](phase_profile &profile) {
+					std::vector<int> items(n);
+					std::iota(items.begin(), items.end(), 0);
+					scoped_phase phase(profile, "unmerge");
+					if(engine == unmerge::UNMERGE_CLASSIC)
+						unmerge::unmerge_sort(items);
+					else
+						unmerge::direct_unmerge_sort(items);
+				});
+			});
+		}
+
+		for(const char *name : merge_engines) {
+			unmerge::merge_engine engine = unmerge::parse_merge_engine(name);
+
+			benchmark_record base = benchmark_record();
+			base.program = "merge_sort";
+			base.engine = name;
+			base.input = "worst_case";
+			base.n = n;
+			run_case(report, base, options.n_reps, [=]() {
+				std::shared_ptr<std::vector<int>> worst_case(new std::vector<int>(n));
+				std::iota(worst_case->begin(), worst_case->end(), 0);
+				unmerge::direct_unmerge_sort(*worst_case);
+
+				return timed_run([=](phase_profile &profile) {
+					std::vector<int> items = *worst_case;
+					scoped_phase phase(profile, "sort");
+					if(engine == unmerge::MERGE_CLASSIC)
+						unmerge::merge_sort(items);
+					else if(engine == unmerge::MERGE_BUFFERED)
+						unmerge::buffered_merge_sort(items);
+					else if(engine == unmerge::MERGE_PARALLEL)
+						unmerge::parallel_merge_sort(items, n_threads);
+					else if(engine == unmerge::MERGE_GENERIC)
+						unmerge::merge_sort(items.begin(), items.end());
+					else
+						unmerge::kernel_merge_sort(items, unmerge::KERNEL_AVX2);
+				});
+			});
+		}
+	}
+}
+
+void benchmark_gcd(report_state &report, const driver_options &options) {
+	enum gcd_engine { GCD_CALCULATE, GCD_TEMPLATE, GCD_BATCH };
+	const gcd_engine engines[] = {GCD_CALCULATE, GCD_TEMPLATE, GCD_BATCH};
+	const char *engine_names[] = {"calculate_gcd", "gcd", "gcd_batch"};
+	unsigned n_threads = options.n_threads;
+
+	for(std::size_t n = 1000; n <= options.max_n; n *= 10) {
+		for(gcd_engine engine : engines) {
+			benchmark_record base = benchmark_record();
+			base.program = "gcd";
+			base.engine = engine_names[engine];
+			base.input = "uniform_int";
+			base.n = n;
+			run_case(report, base, options.n_reps, [=]() {
+				// every engine sees the same pairs
+				std::mt19937_64 rng(n);
+				std::shared_ptr<std::vector<int>> m(new std::vector<int>(n)), k(new std::vector<int>(n));
+				std::shared_ptr<std::vector<std::uint32_t>> a(new std::vector<std::uint32_t>(n));
+				std::shared_ptr<std::vector<std::uint32_t>> b(new std::vector<std::uint32_t>(n));
+				for(std::size_t i = 0; i < n; i++) {
+					(*m)[i] = (int)(std::uint32_t)rng();
+					(*k)[i] = (int)(std::uint32_t)rng();
+					(*a)[i] = euclid::magnitude((*m)[i]);
+					(*b)[i] = euclid::magnitude((*k)[i]);
+				}
+
+				return timed_run([=](phase_profile &profile) {
+					std::vector<std::uint32_t> results(n);
+					if(engine == GCD_CALCULATE) {
+						cout_silencer silence;
+						scoped_phase phase(profile, "gcd");
+						for(std::size_t i = 0; i < n; i++) {
+							euclid::calculate_gcd((*m)[i], (*k)[i]);
+						}
+					}
+					else if(engine == GCD_TEMPLATE) {
+						scoped_phase phase(profile, "gcd");
+						for(std::size_t i = 0; i < n; i++) {
+							results[i] = euclid::gcd((*m)[i], (*k)[i]);
+						}
+					}
+					else {
+						scoped_phase phase(profile, "gcd");
+						euclid::gcd_batch(a->data(), b->data(), results.data(), n, n_threads);
+					}
+				});
+			});
+		}
+	}
+}
+
+int main (int argc, char *argv[]) {
+	driver_options options;
+	options.max_n = 1000000;
+	options.n_reps = 7;
+	options.n_threads = 1;
+	options.format = REPORT_CSV;
+	options.programs = {"hull", "topo", "merge", "gcd"};
+
+	for(int i = 1; i < argc; i++) {
+		std::string arg(argv[i]);
+		if(arg.compare(0, 9, "--format=") == 0) {
+			if(arg.substr(9) == "csv")
+				options.format = REPORT_CSV;
+			else if(arg.substr(9) == "json")
+				options.format = REPORT_JSON;
+			else {
+				std::cerr << "unknown format: " << arg.substr(9) << std::endl << std::endl;
+				usage(argv[0]);
+
+				return -1;
+			}
+		}
+		else if(arg.compare(0, 7, "--reps=") == 0) {
+			std::istringstream iss(arg.substr(7));
+			if((iss >> options.n_reps).fail() || !iss.eof() || options.n_reps == 0) {
+				std::cerr << arg.substr(7) << " is not a valid number of repetitions." << std::endl << std::endl;
+				usage(argv[0]);
+
+				return -1;
+			}
+		}
+		else if(arg.compare(0, 8, "--max-n=") == 0) {
+			std::istringstream iss(arg.substr(8));
+			if((iss >> options.max_n).fail() || !iss.eof()) {
+				std::cerr << arg.substr(8) << " is not a valid size." << std::endl << std::endl;
+				usage(argv[0]);
+
+				return -1;
+			}
+		}
+		else if(arg.compare(0, 10, "--threads=") == 0) {
+			std::istringstream iss(arg.substr(10));
+			if((iss >> options.n_threads).fail() || !iss.eof() || options.n_threads == 0) {
+				std::cerr << arg.substr(10) << " is not a valid number of threads." << std::endl << std::endl;
+				usage(argv[0]);
+
+				return -1;
+			}
+		}
+		else if(arg.compare(0, 11, "--programs=") == 0) {
+			options.programs.clear();
+			std::istringstream iss(arg.substr(11));
+			std::string program;
+			while(std::getline(iss, program, ',')) {
+				if(program != "hull" && program != "topo" && program != "merge" && program != "gcd") {
+					std::cerr << "unknown program: " << program << std::endl << std::endl;
+					usage(argv[0]);
+
+					return -1;
+				}
+				options.programs.push_back(program);
+			}
+		}
+		else {
+			std::cerr << "unknown option: " << arg << std::endl << std::endl;
+			usage(argv[0]);
+
+			return -1;
+		}
+	}
+
+	report_state report = {std::cout, options.format, 0};
+	try {
+		write_report_header(report.os, report.format);
+		for(const std::string &program : options.programs) {
+			if(program == "hull")
+				benchmark_hull(report, options);
+			else if(program == "topo")
+				benchmark_topological_sort(report, options);
+			else if(program == "merge")
+				benchmark_merge_sort(report, options);
+			else
+				benchmark_gcd(report, options);
+		}
+		write_report_footer(report.os, report.format);
+	}
+	catch (std::exception &ex) {
+		std::cerr << ex.what() << std::endl;
+		return -1;
+	}
+
+	return 0;
+}
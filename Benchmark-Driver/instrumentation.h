@@ -0,0 +1,442 @@
+/*
+	Title:    instrumentation.h
+	Purpose:  Phase timers, hardware counters and peak memory shared by the benchmarks
+*/
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#define INSTRUMENTATION_PERF_EVENTS
+#endif
+
+/* Hardware counter.
+ *
+ * The events perf_counters counts: CPU cycles, last-level cache misses and mispredicted
+ * branches.
+ * */
+enum hardware_counter { COUNTER_CYCLES, COUNTER_CACHE_MISSES, COUNTER_BRANCH_MISSES, N_HARDWARE_COUNTERS };
+
+/* Gets the name of a hardware counter.
+ *
+ * @param counter - the counter
+ *
+ * @return the name of counter used in the benchmark output
+ * */
+const char * hardware_counter_name(hardware_counter counter);
+
+/* Hardware counter values.
+ *
+ * The value of each hardware_counter, with valid[i] false when counter i could not be opened,
+ * e.g. because perf_event_paranoid forbids it or the machine is a virtual machine without a
+ * performance monitoring unit.
+ * */
+struct counter_values {
+	bool valid[N_HARDWARE_COUNTERS];
+	std::uint64_t value[N_HARDWARE_COUNTERS];
+
+	counter_values() {
+		std::fill(valid, valid + N_HARDWARE_COUNTERS, false);
+		std::fill(value, value + N_HARDWARE_COUNTERS, 0);
+	}
+};
+
+/* Hardware counters.
+ *
+ * The hardware_counter events of the calling thread, counted in user space by perf_event_open
+ * from the moment the object is created. Each event is opened on its own with inherit set, so
+ * the threads the calling thread creates afterwards are counted too once they have been
+ * joined. Events that cannot be opened are left out and only read as invalid, so the
+ * benchmarks run the same with or without them.
+ * */
+class perf_counters {
+public:
+	perf_counters();
+	~perf_counters();
+
+	/* Reads the counters.
+	 *
+	 * @return the value of every counter since the object was created
+	 * */
+	counter_values read() const;
+
+	/* Checks if any counter could be opened.
+	 *
+	 * @return true if at least one counter is counting
+	 * */
+	bool available() const;
+
+private:
+	perf_counters(const perf_counters &);
+	perf_counters & operator=(const perf_counters &);
+
+	int fds[N_HARDWARE_COUNTERS];
+};
+
+/* Phase.
+ *
+ * The time and the hardware counters spent in one named phase of a run.
+ * */
+struct phase_record {
+	std::string name;
+	double us;
+	counter_values counters;
+};
+
+/* Phase profile.
+ *
+ * The phases timed during one run, in the order they finished. Phases that nest are all
+ * recorded, each with its own time and counters.
+ * */
+class phase_profile {
+public:
+	/*
+	 * Creates an empty profile.
+	 *
+	 * @param counters - the counters read at the start and end of each phase, or null to only
+	 *                   time the phases
+	 * */
+	explicit phase_profile(const perf_counters *counters = 0) : counters(counters) {}
+
+	/* Adds a phase timed elsewhere.
+	 *
+	 * This function records a phase whose time was measured by the code being benchmarked,
+	 * e.g. the phase times of read_csr_graph, without any counters.
+	 *
+	 * @param name - the name of the phase
+	 * @param us - the time spent in the phase in microseconds
+	 * @param phase_counters - the counters of the phase, if any were read
+	 * */
+	void add(const std::string &name, double us, const counter_values &phase_counters = counter_values());
+
+	const std::vector<phase_record> & phases() const { return records; }
+	const perf_counters * perf() const { return counters; }
+	void clear() { records.clear(); }
+
+private:
+	const perf_counters *counters;
+	std::vector<phase_record> records;
+};
+
+/* Scoped phase timer.
+ *
+ * Times the scope it lives in with std::chrono::steady_clock and reads the counters of the
+ * profile when it is created and destroyed, adding the phase to the profile on destruction.
+ * */
+class scoped_phase {
+public:
+	scoped_phase(phase_profile &profile, const std::string &name);
+	~scoped_phase();
+
+private:
+	scoped_phase(const scoped_phase &);
+	scoped_phase & operator=(const scoped_phase &);
+
+	phase_profile &profile;
+	std::string name;
+	counter_values start_counters;
+	std::chrono::steady_clock::time_point start;
+};
+
+/* Peak resident set size.
+ *
+ * @return the largest resident set size of the calling process so far in kilobytes, as
+ *         reported by getrusage
+ * */
+long peak_rss_kb();
+
+/* Percentile of a sample.
+ *
+ * @param samples - the sample; it is sorted in place
+ * @param pct - the percentile to find, between 0 and 100
+ *
+ * @return the nearest-rank percentile of samples
+ * */
+double percentile(std::vector<double> &samples, double pct);
+
+/* Benchmark output format.
+ *
+ * CSV writes a header and one row per record. JSON writes an array of objects with the same
+ * fields, one per line, with null for the counters that were not available.
+ * */
+enum report_format { REPORT_CSV, REPORT_JSON };
+
+/* Benchmark record.
+ *
+ * The summary of one phase of one benchmark case: which program, engine and input it ran and
+ * at what size, the median and 99th percentile of its time over the timed repetitions, the
+ * median of each counter and the peak resident set size of the process running the case.
+ * */
+struct benchmark_record {
+	std::string program;
+	std::string engine;
+	std::string input;
+	std::size_t n;
+	unsigned reps;
+	std::string phase;
+	double median_us;
+	double p99_us;
+	counter_values counters;
+	long peak_rss_kb;
+};
+
+/* Summarizes the repetitions of a benchmark case.
+ *
+ * This function finds every phase name in profiles, in the order of their first appearance,
+ * and appends one record for each phase to ret_records with the median and 99th percentile of
+ * its time and the median of each counter over the profiles it appears in. A phase that
+ * appears more than once in a profile has its times and counters summed first.
+ *
+ * @param base - the program, engine, input, n and peak_rss_kb of every record
+ * @param profiles - the profile of each timed repetition
+ * @param ret_records - the records are appended here
+ * */
+void summarize_phases(const benchmark_record &base, const std::vector<phase_profile> &profiles,
+	std::vector<benchmark_record> &ret_records);
+
+/* Writes the start of a report.
+ *
+ * @param os - the stream the report is written to
+ * @param format - the format of the report
+ * */
+void write_report_header(std::ostream &os, report_format format);
+
+/* Writes a record of a report.
+ *
+ * @param os - the stream the report is written to
+ * @param format - the format of the report
+ * @param record - the record to write
+ * @param first - true if no record has been written to the report yet
+ * */
+void write_report_record(std::ostream &os, report_format format, const benchmark_record &record, bool first);
+
+/* Writes the end of a report.
+ *
+ * @param os - the stream the report is written to
+ * @param format - the format of the report
+ * */
+void write_report_footer(std::ostream &os, report_format format);
+
+
+
+
+
+
+inline const char * hardware_counter_name(hardware_counter counter) {
+	switch(counter) {
+	case COUNTER_CYCLES:
+		return "cycles";
+	case COUNTER_CACHE_MISSES:
+		return "cache_misses";
+	case COUNTER_BRANCH_MISSES:
+		return "branch_misses";
+	default:
+		return "unknown";
+	}
+}
+
+inline perf_counters::perf_counters() {
+	std::fill(fds, fds + N_HARDWARE_COUNTERS, -1);
+#ifdef INSTRUMENTATION_PERF_EVENTS
+	const std::uint64_t configs[N_HARDWARE_COUNTERS] = {
+		PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+	};
+
+	for(int i = 0; i < N_HARDWARE_COUNTERS; i++) {
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = configs[i];
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.inherit = 1;
+		fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+#endif
+}
+
+inline perf_counters::~perf_counters() {
+	for(int fd : fds) {
+		if(fd >= 0)
+			close(fd);
+	}
+}
+
+inline counter_values perf_counters::read() const {
+	counter_values values;
+	for(int i = 0; i < N_HARDWARE_COUNTERS; i++) {
+		std::uint64_t value;
+		if(fds[i] >= 0 && ::read(fds[i], &value, sizeof(value)) == (ssize_t)sizeof(value)) {
+			values.valid[i] = true;
+			values.value[i] = value;
+		}
+	}
+	return values;
+}
+
+inline bool perf_counters::available() const {
+	return std::any_of(fds, fds + N_HARDWARE_COUNTERS, [](int fd) { return fd >= 0; });
+}
+
+inline void phase_profile::add(const std::string &name, double us, const counter_values &phase_counters) {
+	phase_record record;
+	record.name = name;
+	record.us = us;
+	record.counters = phase_counters;
+	records.push_back(record);
+}
+
+inline scoped_phase::scoped_phase(phase_profile &profile, const std::string &name)
+	: profile(profile), name(name) {
+	if(profile.perf())
+		start_counters = profile.perf()->read();
+	// the clock is read last so the time does not include reading the counters
+	start = std::chrono::steady_clock::now();
+}
+
+inline scoped_phase::~scoped_phase() {
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	counter_values counters;
+	if(profile.perf()) {
+		counter_values end_counters = profile.perf()->read();
+		for(int i = 0; i < N_HARDWARE_COUNTERS; i++) {
+			counters.valid[i] = start_counters.valid[i] && end_counters.valid[i];
+			counters.value[i] = counters.valid[i] ? end_counters.value[i] - start_counters.value[i] : 0;
+		}
+	}
+	profile.add(name, std::chrono::duration<double, std::micro>(end - start).count(), counters);
+}
+
+inline long peak_rss_kb() {
+	rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+	return usage.ru_maxrss;
+}
+
+inline double percentile(std::vector<double> &samples, double pct) {
+	if(samples.empty())
+		return 0;
+	std::sort(samples.begin(), samples.end());
+	std::size_t rank = (std::size_t)std::ceil(pct / 100.0 * (double)samples.size());
+	return samples[rank > 0 ? rank - 1 : 0];
+}
+
+inline void summarize_phases(const benchmark_record &base, const std::vector<phase_profile> &profiles,
+	std::vector<benchmark_record> &ret_records) {
+	std::vector<std::string> names;
+	for(const phase_profile &profile : profiles) {
+		for(const phase_record &phase : profile.phases()) {
+			if(std::find(names.begin(), names.end(), phase.name) == names.end())
+				names.push_back(phase.name);
+		}
+	}
+
+	for(const std::string &name : names) {
+		std::vector<double> times;
+		std::vector<double> counts[N_HARDWARE_COUNTERS];
+		bool valid[N_HARDWARE_COUNTERS];
+		std::fill(valid, valid + N_HARDWARE_COUNTERS, true);
+
+		for(const phase_profile &profile : profiles) {
+			phase_record total;
+			bool found = false;
+			total.us = 0;
+			for(const phase_record &phase : profile.phases()) {
+				if(phase.name != name)
+					continue;
+				total.us += phase.us;
+				for(int i = 0; i < N_HARDWARE_COUNTERS; i++) {
+					total.counters.valid[i] = found ? total.counters.valid[i] && phase.counters.valid[i]
+						: phase.counters.valid[i];
+					total.counters.value[i] += phase.counters.value[i];
+				}
+				found = true;
+			}
+			if(!found)
+				continue;
+
+			times.push_back(total.us);
+			for(int i = 0; i < N_HARDWARE_COUNTERS; i++) {
+				valid[i] = valid[i] && total.counters.valid[i];
+				counts[i].push_back((double)total.counters.value[i]);
+			}
+		}
+
+		benchmark_record record = base;
+		record.reps = (unsigned)times.size();
+		record.phase = name;
+		record.median_us = percentile(times, 50);
+		record.p99_us = percentile(times, 99);
+		for(int i = 0; i < N_HARDWARE_COUNTERS; i++) {
+			record.counters.valid[i] = valid[i] && !counts[i].empty();
+			record.counters.value[i] = record.counters.valid[i] ? (std::uint64_t)percentile(counts[i], 50) : 0;
+		}
+		ret_records.push_back(record);
+	}
+}
+
+inline void write_report_header(std::ostream &os, report_format format) {
+	if(format == REPORT_JSON) {
+		os << "[" << std::endl;
+		return;
+	}
+
+	os << "program,engine,input,n,reps,phase,median_us,p99_us";
+	for(int i = 0; i < N_HARDWARE_COUNTERS; i++)
+		os << "," << hardware_counter_name((hardware_counter)i);
+	os << ",peak_rss_kb" << std::endl;
+}
+
+inline void write_report_record(std::ostream &os, report_format format, const benchmark_record &record, bool first) {
+	// one line for the whole record so a dashboard can also read the report line by line
+	std::ostringstream line;
+	if(format == REPORT_CSV) {
+		line << record.program << "," << record.engine << "," << record.input << "," << record.n << ","
+			<< record.reps << "," << record.phase << "," << record.median_us << "," << record.p99_us;
+		for(int i = 0; i < N_HARDWARE_COUNTERS; i++) {
+			line << ",";
+			if(record.counters.valid[i])
+				line << record.counters.value[i];
+		}
+		line << "," << record.peak_rss_kb;
+	}
+	else {
+		// the names are identifiers chosen by the driver, so they need no escaping
+		line << (first ? "  " : ", ") << "{\"program\": \"" << record.program << "\", \"engine\": \""
+			<< record.engine << "\", \"input\": \"" << record.input << "\", \"n\": " << record.n
+			<< ", \"reps\": " << record.reps << ", \"phase\": \"" << record.phase << "\", \"median_us\": "
+			<< record.median_us << ", \"p99_us\": " << record.p99_us;
+		for(int i = 0; i < N_HARDWARE_COUNTERS; i++) {
+			line << ", \"" << hardware_counter_name((hardware_counter)i) << "\": ";
+			if(record.counters.valid[i])
+				line << record.counters.value[i];
+			else
+				line << "null";
+		}
+		line << ", \"peak_rss_kb\": " << record.peak_rss_kb << "}";
+	}
+	os << line.str() << std::endl;
+}
+
+inline void write_report_footer(std::ostream &os, report_format format) {
+	if(format == REPORT_JSON)
+		os << "]" << std::endl;
+}
+
+#endif
@@ -6,27 +6,72 @@
 			  and display them in lexicographical order
 */
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <exception>
 #include <fstream>
 #include <iterator>
 #include <iostream>
+#include <memory>
+#include <random>
 #include <set>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
+#include <tuple>
 #include <utility>
 #include <vector>
 
 #include <cerrno>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
 #include <cstring>
 
 #include <sys/time.h>
 
+#include "../Mapped-File/mapped_file.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HULL_X86_SIMD
+#endif
+
+// keeps the compiler from fusing the multiplications and additions of the SIMD kernels
+#if defined(__GNUC__) && !defined(__clang__)
+#define HULL_NO_FMA __attribute__((optimize("fp-contract=off")))
+#else
+#define HULL_NO_FMA
+#endif
+
 /* Point.
  *
  * Points will be stored in a std::pair<double,double>. This typedef has been added for convenience.
  * */
 typedef std::pair<double,double> point;
 
+/* Point view.
+ *
+ * A read-only view of a contiguous array of points that does not own the points. It is
+ * used by the convex hull algorithms so the points can come either from a std::vector or
+ * directly from a memory-mapped point_cloud file without being copied.
+ * */
+struct point_view {
+	const point *first;
+	size_t n;
+
+	point_view() : first(0), n(0) {}
+	point_view(const point *first, size_t n) : first(first), n(n) {}
+	point_view(const std::vector<point> &pts) : first(pts.data()), n(pts.size()) {}
+
+	size_t size() const { return n; }
+	bool empty() const { return n == 0; }
+	const point & operator[](size_t i) const { return first[i]; }
+	const point * begin() const { return first; }
+	const point * end() const { return first + n; }
+};
+
 /* Prints a point.
  *
  * This function is used to add a point to an ostream. The point is printed in the form "(pt.first,pt.second)".
@@ -81,7 +126,8 @@ void usage(char *name);
  * This function reads points from filename and stores them in ret_pts. Each line of filename
  * is assumed to be of the form "x y" where x and y are doubles. Points are added to the end
  * of ret_pts and the original points are left intact. Duplicate points are found in the file
- * are ignored.
+ * are ignored. The file is memory-mapped and parsed in place; the points are added in
+ * lexicographical order.
  *
  * @param filename - name of the file to read
  * @param ret_pts - container used to store points
@@ -91,6 +137,243 @@ void usage(char *name);
  * */
 void read_points(const std::string &filename, std::vector<point> &ret_pts);
 
+/* Binary point cloud header.
+ *
+ * A point cloud file starts with this header and is followed by n_points pairs of doubles
+ * (x then y) in the byte order of the machine that wrote it. The flags tell whether the
+ * points are already in lexicographical order (POINT_CLOUD_SORTED) and free of duplicates
+ * (POINT_CLOUD_UNIQUE). The bounding box is that of all the points; it is all 0 for an
+ * empty file.
+ * */
+struct point_cloud_header {
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t flags;
+	std::uint64_t n_points;
+	double min_x, min_y, max_x, max_y;
+};
+
+const char POINT_CLOUD_MAGIC[8] = {'H', 'U', 'L', 'L', 'P', 'T', 'S', '\0'};
+const std::uint32_t POINT_CLOUD_VERSION = 1;
+const std::uint32_t POINT_CLOUD_SORTED = 1;
+const std::uint32_t POINT_CLOUD_UNIQUE = 2;
+
+/* Writes a binary point cloud.
+ *
+ * This function writes pts to filename in the point cloud format. The sorted and unique
+ * flags are set if the points are in lexicographical order without duplicates, which is
+ * always the case for the points returned by read_points.
+ *
+ * @param filename - name of the file to write
+ * @param pts - the points to write
+ *
+ * @throws std::runtime_error - thrown if there is an i/o error
+ * */
+void write_point_cloud(const std::string &filename, point_view pts);
+
+/* Checks for a binary point cloud.
+ *
+ * This function checks whether filename starts with the point cloud magic number.
+ *
+ * @param filename - name of the file to check
+ *
+ * @return true if filename is a point cloud file
+ * */
+bool is_point_cloud(const std::string &filename);
+
+/* Binary point cloud.
+ *
+ * This class memory-maps a point cloud file and gives access to its points without copying
+ * or parsing them. If the header does not say the points are sorted and unique they are
+ * sorted and deduplicated in place; the mapping is copy-on-write so the file itself is never
+ * changed.
+ * */
+class point_cloud {
+public:
+	/* Maps a point cloud file.
+	 *
+	 * @param filename - name of the file to map
+	 *
+	 * @throws std::runtime_error - thrown if there is an i/o error or the file is not a valid
+	 *                              point cloud
+	 * */
+	explicit point_cloud(const std::string &filename);
+
+	const point_cloud_header & header() const { return header_; }
+	point_view points() const { return points_; }
+
+private:
+	mapped_file file_;
+	point_cloud_header header_;
+	point_view points_;
+};
+
+/* Structure-of-arrays points.
+ *
+ * The x and y values of a collection of points are stored in two separate contiguous arrays
+ * so the line equation can be evaluated for several points at once using SIMD instructions.
+ * The largest absolute x and y values are kept up to date to bound the rounding error of the
+ * line equation.
+ * */
+struct point_soa {
+	std::vector<double> x;
+	std::vector<double> y;
+	double max_abs_x;
+	double max_abs_y;
+
+	point_soa() : max_abs_x(0), max_abs_y(0) {}
+	explicit point_soa(point_view pts);
+
+	/* Replaces the points.
+	 *
+	 * The arrays keep their capacity, so a point_soa assigned again and again stops
+	 * allocating once it has held the largest collection of points.
+	 *
+	 * @param pts - the points to store
+	 * */
+	void assign(point_view pts);
+
+	size_t size() const { return x.size(); }
+	bool empty() const { return x.empty(); }
+	point operator[](size_t i) const { return point(x[i], y[i]); }
+	void clear() {
+		x.clear();
+		y.clear();
+		max_abs_x = 0;
+		max_abs_y = 0;
+	}
+	void push_back(const point &pt) {
+		x.push_back(pt.first);
+		y.push_back(pt.second);
+		max_abs_x = std::max(max_abs_x, std::fabs(pt.first));
+		max_abs_y = std::max(max_abs_y, std::fabs(pt.second));
+	}
+};
+
+/* Line sides.
+ *
+ * Flags returned by line_sides. LINE_LT is set if a point was found with ax + by - c < -bound
+ * and LINE_GT is set if a point was found with ax + by - c > bound. Points whose value lies
+ * within the error bound [-bound,bound] set neither flag, so their side must be decided by an
+ * exact test.
+ * */
+enum line_side { LINE_LT = 1, LINE_GT = 2, LINE_BOTH = 3 };
+
+/* Line equation error bound.
+ *
+ * Relative error bound of the line equation ax + by - c computed in floating point, relative
+ * to the sum of the magnitudes of its terms (see brute_force_rows and orientation_values).
+ * */
+const double LINE_ERRBOUND = 16 * DBL_EPSILON;
+
+/* Line side kernel.
+ *
+ * The line_sides_* functions evaluate ax + by - c for the n points stored in x and y and
+ * return the line_side flags of the values found. They stop as soon as both sides have been
+ * seen. The *_avx2 and *_avx512 versions evaluate 4 and 8 points at a time and must only be
+ * called on CPUs supporting those instructions.
+ *
+ * @param x - the x values of the points
+ * @param y - the y values of the points
+ * @param n - the number of points
+ * @param a, b, c - the coefficients of the line ax + by = c
+ * @param bound - values within [-bound,bound] do not set a flag
+ *
+ * @return the line_side flags of the points
+ * */
+typedef unsigned (*line_sides_kernel)(const double *x, const double *y, size_t n, double a, double b, double c, double bound);
+unsigned line_sides_scalar(const double *x, const double *y, size_t n, double a, double b, double c, double bound);
+unsigned line_sides_avx2(const double *x, const double *y, size_t n, double a, double b, double c, double bound);
+unsigned line_sides_avx512(const double *x, const double *y, size_t n, double a, double b, double c, double bound);
+
+/* Line value kernel.
+ *
+ * The line_values_* functions store ax + by - c for each of the n points stored in x and y
+ * in ret_vals. The *_avx2 and *_avx512 versions evaluate 4 and 8 points at a time and must
+ * only be called on CPUs supporting those instructions.
+ *
+ * @param x - the x values of the points
+ * @param y - the y values of the points
+ * @param n - the number of points
+ * @param a, b, c - the coefficients of the line ax + by = c
+ * @param ret_vals - array of n values the results are stored in
+ * */
+typedef void (*line_values_kernel)(const double *x, const double *y, size_t n, double a, double b, double c, double *ret_vals);
+void line_values_scalar(const double *x, const double *y, size_t n, double a, double b, double c, double *ret_vals);
+void line_values_avx2(const double *x, const double *y, size_t n, double a, double b, double c, double *ret_vals);
+void line_values_avx512(const double *x, const double *y, size_t n, double a, double b, double c, double *ret_vals);
+
+/* Selects the SIMD kernels.
+ *
+ * These functions return the fastest line_sides_* and line_values_* kernels supported by the
+ * CPU the program is running on.
+ *
+ * @return the fastest supported kernel
+ * */
+line_sides_kernel select_line_sides_kernel();
+line_values_kernel select_line_values_kernel();
+
+/* Line side test.
+ *
+ * This function calls the fastest line_sides_* kernel supported by the CPU. The kernel is
+ * chosen the first time the function is called.
+ *
+ * @param pts - the points to test
+ * @param a, b, c - the coefficients of the line ax + by = c
+ * @param bound - values within [-bound,bound] do not set a flag
+ *
+ * @return the line_side flags of the points
+ * */
+unsigned line_sides(const point_soa &pts, double a, double b, double c, double bound);
+
+/* Orientation of a set of points.
+ *
+ * This function calls the fastest line_values_* kernel supported by the CPU to calculate
+ * orientation(p, q, r) for every point r in pts. The kernel is chosen the first time the
+ * function is called. Values too close to 0 to be sure of their sign are recalculated with
+ * orientation, so the sign of every value is exact. The magnitudes are only accurate to within
+ * the error bound returned, so two values closer than twice the bound may be in the wrong
+ * order.
+ *
+ * @param p - the start of the line
+ * @param q - the end of the line
+ * @param pts - the points to calculate the orientation of
+ * @param ret_vals - resized to pts.size() and used to store the results
+ *
+ * @return the largest error of any value in ret_vals
+ * */
+double orientation_values(const point &p, const point &q, const point_soa &pts, std::vector<double> &ret_vals);
+
+/* Exact line side test.
+ *
+ * This function finds the sides of the line from pts[i] to pts[j] the points lie on like
+ * line_sides does, but uses orientation for every point whose value lies within bound. It is
+ * called by brute_force_rows when line_sides did not find points on both sides.
+ *
+ * @param pts - the points to test
+ * @param i, j - the indices of the points the line goes through
+ * @param a, b, c - the coefficients of the line ax + by = c
+ * @param bound - values within [-bound,bound] are settled with orientation
+ *
+ * @return the exact line_side flags of the points
+ * */
+unsigned exact_line_sides(point_view pts, size_t i, size_t j, double a, double b, double c, double bound);
+
+/* Brute force convex hull helper function.
+ *
+ * This function tests every line from pts[i] to pts[j] with first <= i < last and i < j and
+ * is called by the brute_force_convex_hull function. The lines that have all the points on
+ * the same side are added to ret_sgmts in the same order the serial algorithm finds them.
+ *
+ * @parm pts - a vector of n>1 points for which to find the convex hull
+ * @parm soa - the same points stored as a point_soa
+ * @parm first - the first row of the (i,j) pair space to test (inclusive)
+ * @parm last - the last row of the (i,j) pair space to test (exclusive)
+ * @parm ret_sgmts - line segments composing the convex hull are added to this vector
+ * */
+void brute_force_rows(point_view pts, const point_soa &soa, size_t first, size_t last,
+	std::vector<line_segment> &ret_sgmts);
+
 /* Convex hull algorithm.
  *
  * This function calculates the convex hull of the pts vector. It is assumed that pts contain 2
@@ -98,194 +381,1941 @@ void read_points(const std::string &filename, std::vector<point> &ret_pts);
  * they are vertices of said polygon. The line segments defining the convex polygon are added
  * to ret_sgmts.
  *
+ * If n_threads is greater than 1, the triangular (i, j>i) pair space is split into chunks with
+ * about the same number of pairs each, and the threads take the next unprocessed chunk until
+ * none are left. Every chunk collects its line segments in a buffer of its own; the buffers
+ * are appended to ret_sgmts in chunk order at the end, so the result is exactly the same as
+ * with a single thread.
+ *
  * @parm pts - a vector of n>1 points for which to find the convex hull
  * @parm ret_sgmts - line segments composing the convex hull are added to this vector
+ * @parm n_threads - the number of threads to use
  * */
-void brute_force_convex_hull(const std::vector<point> &pts, std::vector<line_segment> &ret_sgmts);
+void brute_force_convex_hull(point_view pts, std::vector<line_segment> &ret_sgmts,
+	unsigned n_threads = 1);
 
-/*
- * Finds the convex hull.
+/* Convex hull algorithm.
  *
- * This function is a wrapper to the brute_force_convex_hull function. It accepts a collection
- * of points and passes them to the brute_force_convex_hull function. The points comprising the
- * line segements returned by the brute_force_convex_hull are copied to the ret_pts vector. 
+ * The algorithms find_hull is able to use to calculate the convex hull. BRUTE_FORCE is the
+ * original O(n^3) algorithm and is kept as the reference implementation. MONOTONE_CHAIN and
+ * GRAHAM_SCAN both run in O(n log n). QUICKHULL is output sensitive and is the best choice
+ * when only a few of the points lie on the hull. INCREMENTAL inserts the points one at a time
+ * into an incremental_hull.
+ * */
+enum hull_algorithm { BRUTE_FORCE, MONOTONE_CHAIN, GRAHAM_SCAN, QUICKHULL, INCREMENTAL };
+
+/* Convex hull statistics.
  *
- * @param pts - the points for which to find the convex hull
- * @param hull_pts - the vector the vertices of the convex hull are copied into
+ * Counters describing the work done by find_hull. Counters that do not apply to the
+ * algorithm used are left at 0.
  * */
-void find_hull(const std::vector<point> &pts, std::vector<point> &ret_hull_pts);
+struct hull_stats {
+	// number of points the Akl-Toussaint prefilter discarded before running QuickHull
+	size_t n_discarded;
+	// number of orientation tests that needed exact arithmetic
+	unsigned long long n_exact;
 
+	hull_stats() : n_discarded(0), n_exact(0) {}
+};
 
+/* Parses the name of a convex hull algorithm.
+ *
+ * This function converts the name given to the --algorithm option ("brute", "monotone",
+ * "graham", "quickhull" or "incremental") to the matching hull_algorithm.
+ *
+ * @param name - the name of the algorithm
+ *
+ * @return the hull_algorithm with the given name
+ *
+ * @throws std::invalid_argument - thrown if name is not the name of an algorithm
+ * */
+hull_algorithm parse_algorithm(const std::string &name);
 
+/* Gets the name of a convex hull algorithm.
+ *
+ * @param algorithm - the algorithm
+ *
+ * @return the name parse_algorithm accepts for algorithm
+ * */
+const char * algorithm_name(hull_algorithm algorithm);
 
+/* Orientation of three points.
+ *
+ * This function returns the cross product of the vectors p->q and p->r. The result is
+ * positive if p, q and r make a counter-clockwise turn, negative if they make a clockwise
+ * turn and zero if they are collinear. The sign is always exact: the product is first
+ * computed in floating point and, as in Shewchuk's orient2d, only when it is smaller than its
+ * error bound is it recalculated with orientation_exact.
+ *
+ * @param p - the point both vectors start at
+ * @param q - the end of the first vector
+ * @param r - the end of the second vector
+ *
+ * @return the cross product of p->q and p->r
+ * */
+double orientation(const point &p, const point &q, const point &r);
 
+/* Exact orientation of three points.
+ *
+ * This function calculates the same cross product as orientation using exact floating-point
+ * expansion arithmetic and counts the call in n_exact_orientations.
+ *
+ * @param p - the point both vectors start at
+ * @param q - the end of the first vector
+ * @param r - the end of the second vector
+ *
+ * @return the cross product of p->q and p->r rounded to a double; its sign is exact
+ * */
+double orientation_exact(const point &p, const point &q, const point &r);
 
-std::ostream & operator<<(std::ostream &os, const point &pt) {
-	os << "(" << pt.first << "," << pt.second << ")";
-	return os;
-}
+/* Exact comparison of the distances of two points from a line.
+ *
+ * This function calculates orientation(p, q, r) - orientation(p, q, s), which is positive if
+ * r lies farther to the left of the line from p to q than s, with the same exact expansion
+ * arithmetic as orientation_exact, and counts the call in n_exact_orientations.
+ *
+ * @param p - the start of the line
+ * @param q - the end of the line
+ * @param r - the first point to compare
+ * @param s - the second point to compare
+ *
+ * @return the difference of the cross products rounded to a double; its sign is exact
+ * */
+double line_distance_difference_exact(const point &p, const point &q, const point &r, const point &s);
 
-std::ostream & operator <<(std::ostream &os, const std::vector<point> &pts) {
-	std::vector<point>::const_iterator iter = pts.begin();
-	while(iter != pts.end()) {
-		os << *iter;
-		++iter;
-		if(iter != pts.end()) {
-			os << std::endl;
-		}
-	}
-	return os;
-}
+/* Exact sum of two doubles.
+ *
+ * Stores a + b rounded in ret_sum and the rounding error in ret_err, so that
+ * a + b == ret_sum + ret_err exactly.
+ * */
+void two_sum(double a, double b, double &ret_sum, double &ret_err);
 
-const point & get_first(const line_segment &sgmt) {
-	return sgmt.first;
-}
+/* Exact product of two doubles.
+ *
+ * Stores a * b rounded in ret_product and the rounding error in ret_err, so that
+ * a * b == ret_product + ret_err exactly.
+ * */
+void two_product(double a, double b, double &ret_product, double &ret_err);
 
-const point & get_second(const line_segment &sgmt) {
-	return sgmt.second;
-}
+/* Adds a double to an expansion.
+ *
+ * An expansion is an array of non-overlapping doubles in increasing order of magnitude whose
+ * exact sum is the value it represents. This function adds b to the n components of e in
+ * place, drops the components that become 0 and returns the new number of components. e must
+ * have room for n + 1 components.
+ * */
+size_t grow_expansion(double *e, size_t n, double b);
 
-void usage(char *name) {
-	std::cout << "usage: ";
-	std::cout << name << " infile" << std::endl;
-	std::cout << "  infile - file containing points" << std::endl << std::endl;
-	std::cout << "It is assumed that each line of <infile> contains" << std::endl; 
-	std::cout << "a point of form x y where x and y are real numbers." << std::endl;
-}
+/* Exact orientation counter.
+ *
+ * The number of times orientation has fallen back to orientation_exact, shared by all threads.
+ * */
+std::atomic<unsigned long long> n_exact_orientations(0);
 
-void read_points(const std::string &filename, std::vector<point> &ret_pts) {
-	point pt;
-	std::ifstream ifs(filename.c_str());
-	if(ifs) {
-		// read points into a set to remove duplicates
-		std::set<point> pts;
-		while(ifs >> pt.first && ifs >> pt.second) {
-			pts.insert(pt);
-		}
+/* QuickHull scratch buffers.
+ *
+ * The buffers quickhull_helper uses at one depth of its recursion: the orientation values of
+ * its candidates and the points it splits them into for the next depth.
+ * */
+struct quickhull_level {
+	std::vector<double> dist;
+	std::vector<double> o_pc;
+	std::vector<double> o_cq;
+	point_soa left_pc;
+	point_soa left_cq;
+	std::vector<point> on_pc;
+	std::vector<point> on_cq;
+};
 
-		// check if there was an error reading in the file
-		if(ifs.bad()) { // i/o error
-			std::ostringstream oss;
-			oss << filename << ": " << strerror(errno);
-			throw std::runtime_error(oss.str());
-		}
-		else if((ifs.fail() && !ifs.eof())) { // conversion error
-			std::ostringstream oss;
-			oss << filename << ": error reading point";
-			throw std::runtime_error(oss.str());
-		}
+/* Convex hull workspace.
+ *
+ * Scratch buffers find_hull reuses from one call to the next. The buffers are cleared but
+ * never shrunk, so once they have grown to the size of the largest point set a worker sees,
+ * the monotone chain, Graham scan and QuickHull algorithms and the single threaded brute
+ * force algorithm run without allocating. The incremental algorithm still allocates a tree
+ * node for every point it keeps on a chain, and the brute force algorithm allocates a buffer
+ * for every chunk of pairs when it uses more than one thread.
+ * */
+struct hull_workspace {
+	// sorted copy of the points, made when the input is not sorted; QuickHull keeps the
+	// points left by akl_toussaint_filter here
+	std::vector<point> pts;
+	// hull points in the order the algorithm visits them
+	std::vector<point> chain;
+	// x and y arrays of the points for the brute force and QuickHull line kernels
+	point_soa soa;
+	// the points QuickHull finds above, below and on the line between its first two hull
+	// points, with the orientation values it splits them by
+	point_soa upper;
+	point_soa lower;
+	std::vector<point> on_ab;
+	std::vector<point> on_ba;
+	std::vector<double> o_ab;
+	// the buffers of every depth of the QuickHull recursion; a deque keeps the levels in
+	// use in place when a deeper one is added
+	std::deque<quickhull_level> levels;
+	// line segments returned by the algorithm
+	std::vector<line_segment> sgmts;
+	// vertices of the convex hull in lexicographical order
+	std::vector<point> hull_pts;
+};
 
-		// copy the points read to the end of the ret_pts vector
-		std::copy(pts.begin(), pts.end(), std::back_inserter(ret_pts));
-	}
-	else { // error opening file
-		std::ostringstream oss;
-		oss << filename << ": " << strerror(errno);
-		throw std::runtime_error(oss.str());
-	}
-}
+/* Convex hull algorithm.
+ *
+ * This function is brute_force_convex_hull using ws.soa for the x and y arrays of the points
+ * instead of allocating its own. With more than one thread every chunk still collects its
+ * line segments in a buffer of its own.
+ *
+ * @parm pts - a vector of n>1 points for which to find the convex hull
+ * @parm ws - the workspace holding the scratch buffers
+ * @parm ret_sgmts - line segments composing the convex hull are added to this vector
+ * @parm n_threads - the number of threads to use
+ * */
+void brute_force_convex_hull(point_view pts, hull_workspace &ws, std::vector<line_segment> &ret_sgmts,
+	unsigned n_threads = 1);
 
-void brute_force_convex_hull(const std::vector<point> &pts, std::vector<line_segment> &ret_sgmts) {
-	// loops through all the points except the last point
-	for(long long unsigned int i = 0; i < (pts.size() - 1); i++){
+/* Convex hull algorithm.
+ *
+ * This function calculates the convex hull of the pts vector using Andrew's monotone chain
+ * algorithm. The lower and upper hulls are built by sweeping the points in lexicographical
+ * order, which is the order read_points returns them in. If pts is not sorted, a sorted copy
+ * is made first. Points lying on the boundry of the convex polygon are kept so the result
+ * matches brute_force_convex_hull. The line segments defining the convex polygon are added
+ * to ret_sgmts.
+ *
+ * @parm pts - a vector of n>1 points for which to find the convex hull
+ * @parm ret_sgmts - line segments composing the convex hull are added to this vector
+ * */
+void monotone_chain_convex_hull(point_view pts, std::vector<line_segment> &ret_sgmts);
 
-		// loops through all the points except the first point
-		for(long long unsigned int j = i + 1; j < (pts.size()); j++){
+/* Convex hull algorithm.
+ *
+ * This function is monotone_chain_convex_hull using the buffers of ws for the sorted copy and
+ * the chains instead of allocating its own.
+ *
+ * @parm pts - a vector of n>1 points for which to find the convex hull
+ * @parm ws - the workspace holding the scratch buffers
+ * @parm ret_sgmts - line segments composing the convex hull are added to this vector
+ * */
+void monotone_chain_convex_hull(point_view pts, hull_workspace &ws, std::vector<line_segment> &ret_sgmts);
 
-			// finds a, b, and c for ax + by = c
-			double a = pts[j].second - pts[i].second;
-			double b = pts[i].first - pts[j].first;
-			double c = (pts[j].second * pts[i].first) - (pts[i].second * pts[j].first);
+/* Convex hull algorithm.
+ *
+ * This function calculates the convex hull of the pts vector using the Graham scan. The
+ * points are sorted by polar angle around the lowest point and then scanned once, removing
+ * every point that makes a clockwise turn. Points lying on the boundry of the convex polygon
+ * are kept so the result matches brute_force_convex_hull. The line segments defining the
+ * convex polygon are added to ret_sgmts.
+ *
+ * @parm pts - a vector of n>1 points for which to find the convex hull
+ * @parm ret_sgmts - line segments composing the convex hull are added to this vector
+ * */
+void graham_scan_convex_hull(point_view pts, std::vector<line_segment> &ret_sgmts);
 
-			bool LT = false;
-			bool GT = false;
+/* Convex hull algorithm.
+ *
+ * This function is graham_scan_convex_hull using the buffers of ws for the sorted copy and
+ * the stack instead of allocating its own.
+ *
+ * @parm pts - a vector of n>1 points for which to find the convex hull
+ * @parm ws - the workspace holding the scratch buffers
+ * @parm ret_sgmts - line segments composing the convex hull are added to this vector
+ * */
+void graham_scan_convex_hull(point_view pts, hull_workspace &ws, std::vector<line_segment> &ret_sgmts);
 
-			// loops through all the points
-			for(long long unsigned int k = 0; k < pts.size(); k++){
-				double val = (a * pts[k].first) + (b * pts[k].second) - c;
+/* Akl-Toussaint heuristic.
+ *
+ * This function finds the points of pts that are extreme in the eight compass directions
+ * (minimum and maximum of x, y, x+y and x-y). These points are on the convex hull, so any
+ * point lying strictly inside the polygon they form can not be. The points of pts that are
+ * not inside the polygon are added to ret_pts.
+ *
+ * @param pts - the points to filter
+ * @param ret_pts - the points that may lie on the convex hull are added to this vector
+ *
+ * @return the number of points discarded
+ * */
+size_t akl_toussaint_filter(point_view pts, std::vector<point> &ret_pts);
 
-				// marks LT or GT true for which side of the line from i to j the current point k is on
-				if(val < 0)
-					LT = true;
-				else if(val > 0)
-					GT = true;
-			}
+/* QuickHull helper function.
+ *
+ * This function finds the part of the convex hull between p and q and is called by the
+ * quickhull_convex_hull function. Every point of candidates is assumed to lie strictly to the
+ * left of the line from p to q, and every point of on_line is assumed to lie between p and q.
+ * The point of candidates farthest from the line is on the hull; the function recursively
+ * calls itself with the points left of the lines from p to that point and from that point
+ * to q. Points inside the triangle the three points form are dropped. The points for the
+ * recursive calls are split into levels[depth], which is added if levels has no such depth
+ * yet.
+ *
+ * @param p - the start of the hull edge, a point on the hull
+ * @param q - the end of the hull edge, a point on the hull
+ * @param candidates - the points strictly left of the line from p to q
+ * @param on_line - the points lying on the line between p and q
+ * @param levels - the scratch buffers of every depth of the recursion
+ * @param depth - the depth of this call, 0 for the first one
+ * @param ret_sgmts - line segments composing the convex hull are added to this vector
+ * */
+void quickhull_helper(const point &p, const point &q, const point_soa &candidates,
+	std::vector<point> &on_line, std::deque<quickhull_level> &levels, size_t depth,
+	std::vector<line_segment> &ret_sgmts);
 
-			// adds the line from i to j to the vector if all points are on the same side
-			if(LT != true || GT != true){
-				line_segment line;
-				line.first = pts[i];
-				line.second = pts[j];
-				ret_sgmts.push_back(line);
-			}
-		}
-	}
-}
+/* Convex hull algorithm.
+ *
+ * This function calculates the convex hull of the pts vector using QuickHull. The points are
+ * first passed through akl_toussaint_filter so interior points are never looked at again. The
+ * expected running time is O(n log h) where h is the number of hull points. Points lying on
+ * the boundry of the convex polygon are kept so the result matches brute_force_convex_hull.
+ * The line segments defining the convex polygon are added to ret_sgmts.
+ *
+ * @parm pts - a vector of n>1 points for which to find the convex hull
+ * @parm ret_sgmts - line segments composing the convex hull are added to this vector
+ *
+ * @return the number of points discarded by akl_toussaint_filter
+ * */
+size_t quickhull_convex_hull(point_view pts, std::vector<line_segment> &ret_sgmts);
 
-void find_hull(const std::vector<point> &pts, std::vector<point> &ret_hull_points) {
-	if(pts.size() == 0) {
-		std::ostringstream oss;
-		oss << "error: one or more points are required to find the convex hull";
-		throw std::runtime_error(oss.str());
-	}
-	else if(pts.size() == 1) {
-		// the convex hull of a single point is the point itself
-		ret_hull_points.push_back(*pts.begin());	
-	}
-	else {
-		/* https://stackoverflow.com/a/1041939 
-		 * 
-		 * We need to copy the endpoints of the line segments found in
-		 * brute_force_convex_hull to ret_hull_points, but we don't want duplicate
-		 * points. We will copy the points into a set to remove the duplicates
-		 * and then copy the points to ret_hull_points.
-		 * */
-		std::set<point> pts_set;
-		std::vector<line_segment> sgmts;
-		brute_force_convex_hull(pts, sgmts);
-
-		/* copy the first point of the line segments to pts_set */
-		std::transform(
-			sgmts.begin(),
-			sgmts.end(),
-			std::inserter(pts_set, pts_set.end()),
-			get_first
-		);
-		/* copy the second point of the line segments to pts_set */
-		std::transform(
-			sgmts.begin(),
-			sgmts.end(),
-			std::inserter(pts_set, pts_set.end()),
-			get_second
-		);
-		/* copy the points from pts_set to ret_hull_points */
-		std::copy(pts_set.begin(), pts_set.end(), std::back_inserter(ret_hull_points));
-	}
-}
+/* Convex hull algorithm.
+ *
+ * This function is quickhull_convex_hull using the buffers of ws for the filtered points,
+ * their partitions and every depth of the recursion instead of allocating its own.
+ *
+ * @parm pts - a vector of n>1 points for which to find the convex hull
+ * @parm ws - the workspace holding the scratch buffers
+ * @parm ret_sgmts - line segments composing the convex hull are added to this vector
+ *
+ * @return the number of points discarded by akl_toussaint_filter
+ * */
+size_t quickhull_convex_hull(point_view pts, hull_workspace &ws, std::vector<line_segment> &ret_sgmts);
 
-int main (int argc, char *argv[]) {
-	if(argc != 2) {
-		std::cerr << "Invalid number of arguments." << std::endl << std::endl;
-		usage(argv[0]);
-	}
-	else {
-		try {
-			struct timeval start_tv, end_tv;
-			std::string infile(argv[1]);
-			std::vector<point> pts;
-			std::vector<point> hull_pts;
+/* Incremental convex hull.
+ *
+ * This class maintains the convex hull of a growing set of points. The hull is kept as a lower
+ * and an upper chain, each a balanced search tree of points in lexicographical order, the same
+ * chains monotone_chain_convex_hull builds. Inserting a point costs O(log n) amortized: a point
+ * inside the hull is rejected with one lookup per chain, and a point outside it is added to the
+ * chains that it extends and removes the neighbors it hides. Every point is removed at most
+ * once. Points lying on the boundry of the convex polygon are kept so the result matches
+ * brute_force_convex_hull.
+ * */
+class incremental_hull {
+public:
+	/* Adds a point.
+	 *
+	 * @param pt - the point to add
+	 *
+	 * @return true if pt is a vertex of the hull after it was added
+	 * */
+	bool insert(const point &pt);
 
-			read_points(infile, pts);
-			
-			gettimeofday(&start_tv, 0);
-			find_hull(pts, hull_pts);
-			gettimeofday(&end_tv, 0);
+	/* Adds a collection of points.
+	 *
+	 * @param pts - the points to add
+	 *
+	 * @return the number of points that were vertices of the hull when they were added
+	 * */
+	size_t insert_batch(point_view pts);
 
-			std::cout << "Convex Hull (" << hull_pts.size() << " Points):" << std::endl;
-			std::cout << hull_pts << std::endl;
-			std::cout << "Elapsed Time (microseconds): "
-				<< (end_tv.tv_sec - start_tv.tv_sec)*1000000L + (end_tv.tv_usec - start_tv.tv_usec)
-				<< std::endl;
+	/* Gets the vertices of the hull.
+	 *
+	 * This function returns a snapshot of the vertices of the hull in lexicographical order,
+	 * the same order find_hull returns them in.
+	 *
+	 * @return the vertices of the hull
+	 * */
+	std::vector<point> vertices() const;
+
+	/* Gets the edges of the hull.
+	 *
+	 * This function adds the line segments between consecutive points of both chains to
+	 * ret_sgmts. A hull of a single point is returned as a segment from the point to itself.
+	 *
+	 * @param ret_sgmts - line segments composing the convex hull are added to this vector
+	 * */
+	void segments(std::vector<line_segment> &ret_sgmts) const;
+
+	bool empty() const { return lower_.empty(); }
+
+private:
+	/* Adds a point to a chain.
+	 *
+	 * The lower chain only turns counter-clockwise (sign = 1) and the upper chain only turns
+	 * clockwise (sign = -1) when walked in lexicographical order. pt is not added if it lies
+	 * strictly on the inner side of the chain; otherwise it is added and the neighbors making
+	 * a turn the wrong way are removed.
+	 *
+	 * @param chain - the chain to add pt to
+	 * @param pt - the point to add
+	 * @param sign - 1 for the lower chain, -1 for the upper chain
+	 *
+	 * @return true if pt was added to chain
+	 * */
+	static bool insert_chain(std::set<point> &chain, const point &pt, double sign);
+
+	/* Tests a point against a chain.
+	 *
+	 * @return true if pt lies strictly on the inner side of chain between its end points
+	 * */
+	static bool inside_chain(const std::set<point> &chain, const point &pt, double sign);
+
+	std::set<point> lower_;
+	std::set<point> upper_;
+};
+
+/* Convex hull algorithm.
+ *
+ * This function calculates the convex hull of the pts vector by inserting the points one
+ * at a time into an incremental_hull. The line segments defining the convex polygon are added
+ * to ret_sgmts.
+ *
+ * @parm pts - a vector of n>1 points for which to find the convex hull
+ * @parm ret_sgmts - line segments composing the convex hull are added to this vector
+ * */
+void incremental_convex_hull(point_view pts, std::vector<line_segment> &ret_sgmts);
+
+/* Streams points into an incremental hull.
+ *
+ * This function reads points of the form "x y" from is and adds each one to an incremental
+ * hull as it arrives. Every blank line, and the end of the input, prints a snapshot of the
+ * hull to os.
+ *
+ * @param is - the stream the points are read from
+ * @param os - the stream the snapshots are printed to
+ *
+ * @throws std::runtime_error - thrown if there is an i/o error or conversion error
+ * */
+void stream_hull(std::istream &is, std::ostream &os);
+
+/* Point distribution.
+ *
+ * The shapes generate_points can draw points from: uniformly in the unit square, uniformly in
+ * the unit disk, on the unit circle (the worst case, where every point is on the hull) and
+ * from a standard normal distribution in both coordinates.
+ * */
+enum point_distribution { UNIFORM_SQUARE, UNIFORM_DISK, ON_CIRCLE, GAUSSIAN };
+
+/* Gets the name of a point distribution.
+ *
+ * @param dist - the distribution
+ *
+ * @return the name of dist used in the benchmark output
+ * */
+const char * distribution_name(point_distribution dist);
+
+/* Generates random points.
+ *
+ * This function draws n points from dist using rng and stores them in ret_pts in
+ * lexicographical order without duplicates, the same way read_points returns them.
+ *
+ * @param dist - the distribution to draw the points from
+ * @param n - the number of points to draw
+ * @param rng - the random number generator
+ * @param ret_pts - the points are stored here, replacing its contents
+ * */
+void generate_points(point_distribution dist, size_t n, std::mt19937_64 &rng, std::vector<point> &ret_pts);
+
+/* Percentile of a sample.
+ *
+ * @param samples - the sample; it is sorted in place
+ * @param pct - the percentile to find, between 0 and 100
+ *
+ * @return the nearest-rank percentile of samples
+ * */
+double percentile(std::vector<double> &samples, double pct);
+
+/* Benchmarks the convex hull algorithms.
+ *
+ * This function runs every convex hull algorithm on points from every point_distribution for
+ * n = 100, 1000, ... up to max_n. Each run is repeated n_reps times after one warmup run and
+ * the median and 99th percentile times and the throughput of the median run are written to
+ * os as CSV. The brute force algorithm is only run up to 1000 points.
+ *
+ * @param os - the stream the CSV is written to
+ * @param max_n - the largest number of points to benchmark
+ * @param n_reps - the number of timed runs of each algorithm
+ * @param n_threads - the number of threads the brute force algorithm uses
+ * */
+void run_benchmark(std::ostream &os, size_t max_n, unsigned n_reps, unsigned n_threads);
+
+/*
+ * Finds the convex hull.
+ *
+ * This function is a wrapper to the convex hull algorithms. It accepts a collection of points
+ * and passes them to the convex hull function selected by algorithm. The points comprising the
+ * line segements returned by that function are copied to the ret_pts vector.
+ *
+ * @param pts - the points for which to find the convex hull
+ * @param hull_pts - the vector the vertices of the convex hull are copied into
+ * @param algorithm - the convex hull algorithm to use
+ * @param ret_stats - if not null, the statistics of the algorithm are stored here
+ * @param n_threads - the number of threads the brute force algorithm uses
+ * */
+void find_hull(point_view pts, std::vector<point> &ret_hull_pts,
+	hull_algorithm algorithm = MONOTONE_CHAIN, hull_stats *ret_stats = 0, unsigned n_threads = 1);
+
+/*
+ * Finds the convex hull using a workspace.
+ *
+ * This function is find_hull storing the vertices of the convex hull in ws.hull_pts, replacing
+ * its contents, and keeping every intermediate result in the buffers of ws so repeated calls
+ * with the same workspace do not allocate once the buffers are large enough. The incremental
+ * algorithm, and the brute force algorithm with more than one thread, still allocate on
+ * every call (see hull_workspace).
+ *
+ * @param pts - the points for which to find the convex hull
+ * @param ws - the workspace; the vertices of the convex hull are stored in ws.hull_pts
+ * @param algorithm - the convex hull algorithm to use
+ * @param ret_stats - if not null, the statistics of the algorithm are stored here
+ * @param n_threads - the number of threads the brute force algorithm uses
+ * */
+void find_hull(point_view pts, hull_workspace &ws,
+	hull_algorithm algorithm = MONOTONE_CHAIN, hull_stats *ret_stats = 0, unsigned n_threads = 1);
+
+/* Batch of point sets.
+ *
+ * Many point sets stored back to back in one flat vector. Set i is made of the points from
+ * offsets[i] up to offsets[i + 1], in lexicographical order without duplicates, and was read
+ * from the file or section called names[i].
+ * */
+struct point_batch {
+	std::vector<point> pts;
+	std::vector<size_t> offsets;
+	std::vector<std::string> names;
+
+	point_batch() : offsets(1, 0) {}
+
+	size_t size() const { return names.size(); }
+	point_view set(size_t i) const { return point_view(pts.data() + offsets[i], offsets[i + 1] - offsets[i]); }
+};
+
+/* Reads a multi-section point file.
+ *
+ * This function reads the points of filename the same way read_points does, except that a
+ * blank line ends the current point set and starts the next one. Each non-empty section is
+ * added to ret_batch as a separate set named "filename:line" after the line it starts on.
+ *
+ * @param filename - name of the file to read
+ * @param ret_batch - the point sets are added to this batch
+ *
+ * @throws std::runtime_error - thrown if there is an i/o error or conversion error
+ * */
+void read_point_sections(const std::string &filename, point_batch &ret_batch);
+
+/* Reads the point files listed in a manifest.
+ *
+ * This function reads every file named in manifest, one file name per line, with read_points
+ * (or from the binary point cloud) and adds each file to ret_batch as a separate set. Blank
+ * lines are ignored.
+ *
+ * @param manifest - name of the file listing the point files
+ * @param ret_batch - the point sets are added to this batch
+ *
+ * @throws std::runtime_error - thrown if there is an i/o error or conversion error
+ * */
+void read_point_manifest(const std::string &manifest, point_batch &ret_batch);
+
+/* Finds the convex hulls of a batch of point sets.
+ *
+ * This function finds the convex hull of every set in batch on a pool of n_threads workers.
+ * The workers take the sets a few at a time and each reuses one hull_workspace for all the
+ * sets it processes, so only the incremental algorithm allocates for every set. A hull
+ * never has more vertices than its set has points, so the vertices of set i are written to
+ * ret_hull_pts starting at batch.offsets[i] and their number is stored in ret_counts[i];
+ * both vectors are sized once up front. An empty set has an empty hull.
+ *
+ * @param batch - the point sets
+ * @param ret_hull_pts - the vertices of the convex hulls are stored here
+ * @param ret_counts - the number of vertices of each convex hull is stored here
+ * @param algorithm - the convex hull algorithm to use
+ * @param n_threads - the number of worker threads
+ * */
+void find_hulls(const point_batch &batch, std::vector<point> &ret_hull_pts, std::vector<size_t> &ret_counts,
+	hull_algorithm algorithm = MONOTONE_CHAIN, unsigned n_threads = 1);
+
+
+
+
+
+
+std::ostream & operator<<(std::ostream &os, const point &pt) {
+	os << "(" << pt.first << "," << pt.second << ")";
+	return os;
+}
+
+std::ostream & operator <<(std::ostream &os, const std::vector<point> &pts) {
+	std::vector<point>::const_iterator iter = pts.begin();
+	while(iter != pts.end()) {
+		os << *iter;
+		++iter;
+		if(iter != pts.end()) {
+			os << std::endl;
+		}
+	}
+	return os;
+}
+
+const point & get_first(const line_segment &sgmt) {
+	return sgmt.first;
+}
+
+const point & get_second(const line_segment &sgmt) {
+	return sgmt.second;
+}
+
+void usage(char *name) {
+	std::cout << "usage: ";
+	std::cout << name << " [--algorithm=brute|monotone|graham|quickhull|incremental] [--threads=n] infile" << std::endl;
+	std::cout << "       " << name << " --convert=outfile infile" << std::endl;
+	std::cout << "       " << name << " --stream" << std::endl;
+	std::cout << "       " << name << " --batch=sections|manifest [--algorithm=...] [--threads=n] infile" << std::endl;
+	std::cout << "       " << name << " --benchmark [--reps=n] [--max-n=n] [--threads=n]" << std::endl;
+	std::cout << "  --algorithm - convex hull algorithm to use (default: monotone)" << std::endl;
+	std::cout << "  --threads - number of threads the brute force algorithm uses; 0 uses" << std::endl;
+	std::cout << "              every core (default: 1)" << std::endl;
+	std::cout << "  --convert - write the points of infile to outfile as a binary point cloud" << std::endl;
+	std::cout << "  --stream - add points read from standard input to the hull as they arrive;" << std::endl;
+	std::cout << "             a blank line prints the current hull" << std::endl;
+	std::cout << "  --batch - find the hull of every point set in infile; with sections the sets" << std::endl;
+	std::cout << "            are separated by blank lines, with manifest each line of infile" << std::endl;
+	std::cout << "            names a point file. --threads sets the number of workers; each" << std::endl;
+	std::cout << "            reuses its buffers from set to set, except that incremental" << std::endl;
+	std::cout << "            allocates a node for every hull point of every set" << std::endl;
+	std::cout << "  --benchmark - time every algorithm on generated points and print CSV" << std::endl;
+	std::cout << "  --reps - number of timed runs per benchmark (default: 7)" << std::endl;
+	std::cout << "  --max-n - largest number of points to benchmark (default: 1000000)" << std::endl;
+	std::cout << "  infile - file containing points" << std::endl << std::endl;
+	std::cout << "It is assumed that each line of <infile> contains" << std::endl; 
+	std::cout << "a point of form x y where x and y are real numbers," << std::endl;
+	std::cout << "unless it is a binary point cloud written by --convert." << std::endl;
+}
+
+void read_points(const std::string &filename, std::vector<point> &ret_pts) {
+	point pt;
+	parse_status status;
+	mapped_file file(filename); // throws if there is an error opening the file
+	const char *first = file.begin();
+
+	// read points into a flat vector; duplicates are removed once it is sorted
+	// a point line is rarely shorter than the 16 bytes of the point it holds, so this stays
+	// within the size of the file
+	std::vector<point> pts;
+	pts.reserve(file.size() / sizeof(point));
+	while((status = parse_next(first, file.end(), pt.first)) == PARSE_OK
+		&& (status = parse_next(first, file.end(), pt.second)) == PARSE_OK) {
+		pts.push_back(pt);
+	}
+
+	// check if there was an error reading in the file
+	if(status == PARSE_ERROR) { // conversion error
+		std::ostringstream oss;
+		oss << filename << ": error reading point";
+		throw std::runtime_error(oss.str());
+	}
+
+	// sort the points and remove the duplicates
+	std::sort(pts.begin(), pts.end());
+	pts.erase(std::unique(pts.begin(), pts.end()), pts.end());
+
+	// copy the points read to the end of the ret_pts vector
+	std::copy(pts.begin(), pts.end(), std::back_inserter(ret_pts));
+}
+
+void write_point_cloud(const std::string &filename, point_view pts) {
+	point_cloud_header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, POINT_CLOUD_MAGIC, sizeof(header.magic));
+	header.version = POINT_CLOUD_VERSION;
+	header.n_points = pts.size();
+
+	// finds the bounding box and checks if the points are sorted and unique
+	bool sorted = true, unique = true;
+	for(size_t i = 0; i < pts.size(); i++) {
+		const point &pt = pts[i];
+		if(i == 0 || pt.first < header.min_x) header.min_x = pt.first;
+		if(i == 0 || pt.second < header.min_y) header.min_y = pt.second;
+		if(i == 0 || pt.first > header.max_x) header.max_x = pt.first;
+		if(i == 0 || pt.second > header.max_y) header.max_y = pt.second;
+		if(i > 0 && pt < pts[i - 1]) sorted = false;
+		if(i > 0 && pt == pts[i - 1]) unique = false;
+	}
+	if(sorted) {
+		header.flags |= POINT_CLOUD_SORTED;
+		// duplicates of a sorted array are always next to each other
+		if(unique) {
+			header.flags |= POINT_CLOUD_UNIQUE;
+		}
+	}
+
+	std::ofstream ofs(filename.c_str(), std::ios::binary);
+	if(ofs) {
+		ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		for(size_t i = 0; i < pts.size() && ofs; i++) {
+			double xy[2] = {pts[i].first, pts[i].second};
+			ofs.write(reinterpret_cast<const char *>(xy), sizeof(xy));
+		}
+		ofs.flush();
+	}
+	if(!ofs) { // error opening or writing the file
+		std::ostringstream oss;
+		oss << filename << ": " << strerror(errno);
+		throw std::runtime_error(oss.str());
+	}
+}
+
+bool is_point_cloud(const std::string &filename) {
+	char magic[sizeof(POINT_CLOUD_MAGIC)];
+	std::ifstream ifs(filename.c_str(), std::ios::binary);
+	return ifs.read(magic, sizeof(magic)) && std::memcmp(magic, POINT_CLOUD_MAGIC, sizeof(magic)) == 0;
+}
+
+point_cloud::point_cloud(const std::string &filename) : file_(filename, true) {
+	static_assert(sizeof(point) == 2 * sizeof(double), "point must be two packed doubles");
+	static_assert(sizeof(point_cloud_header) % alignof(double) == 0, "points must be aligned");
+
+	if(file_.size() < sizeof(header_) || std::memcmp(file_.begin(), POINT_CLOUD_MAGIC, sizeof(header_.magic)) != 0) {
+		std::ostringstream oss;
+		oss << filename << ": not a point cloud file";
+		throw std::runtime_error(oss.str());
+	}
+	std::memcpy(&header_, file_.begin(), sizeof(header_));
+	if(header_.version != POINT_CLOUD_VERSION
+		|| header_.n_points > (file_.size() - sizeof(header_)) / sizeof(point)) {
+		std::ostringstream oss;
+		oss << filename << ": error reading point cloud";
+		throw std::runtime_error(oss.str());
+	}
+
+	// the points are used where they were mapped
+	point *pts = reinterpret_cast<point *>(file_.data() + sizeof(header_));
+	size_t n = header_.n_points;
+	const std::uint32_t sorted_unique = POINT_CLOUD_SORTED | POINT_CLOUD_UNIQUE;
+	if((header_.flags & sorted_unique) != sorted_unique) {
+		// sorts the copy-on-write pages and removes the duplicates
+		std::sort(pts, pts + n);
+		n = std::unique(pts, pts + n) - pts;
+	}
+	points_ = point_view(pts, n);
+}
+
+point_soa::point_soa(point_view pts) : max_abs_x(0), max_abs_y(0) {
+	assign(pts);
+}
+
+void point_soa::assign(point_view pts) {
+	x.resize(pts.size());
+	y.resize(pts.size());
+	max_abs_x = 0;
+	max_abs_y = 0;
+	for(size_t i = 0; i < pts.size(); i++) {
+		x[i] = pts[i].first;
+		y[i] = pts[i].second;
+		max_abs_x = std::max(max_abs_x, std::fabs(x[i]));
+		max_abs_y = std::max(max_abs_y, std::fabs(y[i]));
+	}
+}
+
+unsigned line_sides_scalar(const double *x, const double *y, size_t n, double a, double b, double c, double bound) {
+	unsigned sides = 0;
+	for(size_t k = 0; k < n && sides != LINE_BOTH; k++) {
+		double val = (a * x[k]) + (b * y[k]) - c;
+		if(val < -bound)
+			sides |= LINE_LT;
+		else if(val > bound)
+			sides |= LINE_GT;
+	}
+	return sides;
+}
+
+void line_values_scalar(const double *x, const double *y, size_t n, double a, double b, double c, double *ret_vals) {
+	for(size_t k = 0; k < n; k++) {
+		ret_vals[k] = (a * x[k]) + (b * y[k]) - c;
+	}
+}
+
+#ifdef HULL_X86_SIMD
+/* The multiplications and additions are kept separate (HULL_NO_FMA) so the SIMD kernels
+ * produce exactly the same values as the scalar kernels. */
+__attribute__((target("avx2"))) HULL_NO_FMA
+unsigned line_sides_avx2(const double *x, const double *y, size_t n, double a, double b, double c, double bound) {
+	const __m256d va = _mm256_set1_pd(a), vb = _mm256_set1_pd(b), vc = _mm256_set1_pd(c);
+	const __m256d lo = _mm256_set1_pd(-bound), hi = _mm256_set1_pd(bound);
+	unsigned sides = 0;
+	size_t k = 0;
+	for(; k + 4 <= n; k += 4) {
+		__m256d val = _mm256_sub_pd(_mm256_add_pd(
+			_mm256_mul_pd(va, _mm256_loadu_pd(x + k)),
+			_mm256_mul_pd(vb, _mm256_loadu_pd(y + k))), vc);
+		if(_mm256_movemask_pd(_mm256_cmp_pd(val, lo, _CMP_LT_OQ)))
+			sides |= LINE_LT;
+		if(_mm256_movemask_pd(_mm256_cmp_pd(val, hi, _CMP_GT_OQ)))
+			sides |= LINE_GT;
+		if(sides == LINE_BOTH)
+			return sides;
+	}
+	return sides | line_sides_scalar(x + k, y + k, n - k, a, b, c, bound);
+}
+
+__attribute__((target("avx2"))) HULL_NO_FMA
+void line_values_avx2(const double *x, const double *y, size_t n, double a, double b, double c, double *ret_vals) {
+	const __m256d va = _mm256_set1_pd(a), vb = _mm256_set1_pd(b), vc = _mm256_set1_pd(c);
+	size_t k = 0;
+	for(; k + 4 <= n; k += 4) {
+		_mm256_storeu_pd(ret_vals + k, _mm256_sub_pd(_mm256_add_pd(
+			_mm256_mul_pd(va, _mm256_loadu_pd(x + k)),
+			_mm256_mul_pd(vb, _mm256_loadu_pd(y + k))), vc));
+	}
+	line_values_scalar(x + k, y + k, n - k, a, b, c, ret_vals + k);
+}
+
+__attribute__((target("avx512f"))) HULL_NO_FMA
+unsigned line_sides_avx512(const double *x, const double *y, size_t n, double a, double b, double c, double bound) {
+	const __m512d va = _mm512_set1_pd(a), vb = _mm512_set1_pd(b), vc = _mm512_set1_pd(c);
+	const __m512d lo = _mm512_set1_pd(-bound), hi = _mm512_set1_pd(bound);
+	unsigned sides = 0;
+	for(size_t k = 0; k < n; k += 8) {
+		// the last iteration only loads the points that are left
+		__mmask8 mask = (n - k >= 8) ? 0xFF : (__mmask8)((1u << (n - k)) - 1);
+		__m512d val = _mm512_sub_pd(_mm512_add_pd(
+			_mm512_mul_pd(va, _mm512_maskz_loadu_pd(mask, x + k)),
+			_mm512_mul_pd(vb, _mm512_maskz_loadu_pd(mask, y + k))), vc);
+		if(_mm512_mask_cmp_pd_mask(mask, val, lo, _CMP_LT_OQ))
+			sides |= LINE_LT;
+		if(_mm512_mask_cmp_pd_mask(mask, val, hi, _CMP_GT_OQ))
+			sides |= LINE_GT;
+		if(sides == LINE_BOTH)
+			return sides;
+	}
+	return sides;
+}
+
+__attribute__((target("avx512f"))) HULL_NO_FMA
+void line_values_avx512(const double *x, const double *y, size_t n, double a, double b, double c, double *ret_vals) {
+	const __m512d va = _mm512_set1_pd(a), vb = _mm512_set1_pd(b), vc = _mm512_set1_pd(c);
+	for(size_t k = 0; k < n; k += 8) {
+		__mmask8 mask = (n - k >= 8) ? 0xFF : (__mmask8)((1u << (n - k)) - 1);
+		_mm512_mask_storeu_pd(ret_vals + k, mask, _mm512_sub_pd(_mm512_add_pd(
+			_mm512_mul_pd(va, _mm512_maskz_loadu_pd(mask, x + k)),
+			_mm512_mul_pd(vb, _mm512_maskz_loadu_pd(mask, y + k))), vc));
+	}
+}
+#else
+unsigned line_sides_avx2(const double *x, const double *y, size_t n, double a, double b, double c, double bound) {
+	return line_sides_scalar(x, y, n, a, b, c, bound);
+}
+
+void line_values_avx2(const double *x, const double *y, size_t n, double a, double b, double c, double *ret_vals) {
+	line_values_scalar(x, y, n, a, b, c, ret_vals);
+}
+
+unsigned line_sides_avx512(const double *x, const double *y, size_t n, double a, double b, double c, double bound) {
+	return line_sides_scalar(x, y, n, a, b, c, bound);
+}
+
+void line_values_avx512(const double *x, const double *y, size_t n, double a, double b, double c, double *ret_vals) {
+	line_values_scalar(x, y, n, a, b, c, ret_vals);
+}
+#endif
+
+line_sides_kernel select_line_sides_kernel() {
+#ifdef HULL_X86_SIMD
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512f"))
+		return line_sides_avx512;
+	else if(__builtin_cpu_supports("avx2"))
+		return line_sides_avx2;
+#endif
+	return line_sides_scalar;
+}
+
+line_values_kernel select_line_values_kernel() {
+#ifdef HULL_X86_SIMD
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512f"))
+		return line_values_avx512;
+	else if(__builtin_cpu_supports("avx2"))
+		return line_values_avx2;
+#endif
+	return line_values_scalar;
+}
+
+unsigned line_sides(const point_soa &pts, double a, double b, double c, double bound) {
+	// initialized once, even when called from several threads at the same time
+	static const line_sides_kernel kernel = select_line_sides_kernel();
+	return kernel(pts.x.data(), pts.y.data(), pts.size(), a, b, c, bound);
+}
+
+double orientation_values(const point &p, const point &q, const point_soa &pts, std::vector<double> &ret_vals) {
+	static const line_values_kernel kernel = select_line_values_kernel();
+
+	// orientation(p, q, r) written as the line equation ax + by - c of r
+	double a = p.second - q.second;
+	double b = q.first - p.first;
+	double c = (a * p.first) + (b * p.second);
+	ret_vals.resize(pts.size());
+	kernel(pts.x.data(), pts.y.data(), pts.size(), a, b, c, ret_vals.data());
+
+	// recalculates the values that may have the wrong sign
+	double max_x = std::max(pts.max_abs_x, std::max(std::fabs(p.first), std::fabs(q.first)));
+	double max_y = std::max(pts.max_abs_y, std::max(std::fabs(p.second), std::fabs(q.second)));
+	double bound = LINE_ERRBOUND * (std::fabs(a) * max_x + std::fabs(b) * max_y);
+	for(size_t k = 0; k < pts.size(); k++) {
+		if(std::fabs(ret_vals[k]) <= bound)
+			ret_vals[k] = orientation(p, q, pts[k]);
+	}
+	return bound;
+}
+
+unsigned exact_line_sides(point_view pts, size_t i, size_t j, double a, double b, double c, double bound) {
+	unsigned sides = 0;
+	for(size_t k = 0; k < pts.size() && sides != LINE_BOTH; k++) {
+		double val = (a * pts[k].first) + (b * pts[k].second) - c;
+		if(val < -bound) {
+			sides |= LINE_LT;
+		}
+		else if(val > bound) {
+			sides |= LINE_GT;
+		}
+		else if(k != i && k != j) {
+			// ax + by - c has the opposite sign of orientation(pts[i], pts[j], pts[k])
+			double o = orientation(pts[i], pts[j], pts[k]);
+			if(o > 0)
+				sides |= LINE_LT;
+			else if(o < 0)
+				sides |= LINE_GT;
+		}
+	}
+	return sides;
+}
+
+void brute_force_rows(point_view pts, const point_soa &soa, size_t first, size_t last,
+	std::vector<line_segment> &ret_sgmts) {
+	// loops through the rows of points given
+	for(long long unsigned int i = first; i < last; i++){
+
+		// loops through all the points except the first point
+		for(long long unsigned int j = i + 1; j < (pts.size()); j++){
+
+			// finds a, b, and c for ax + by = c
+			double a = pts[j].second - pts[i].second;
+			double b = pts[i].first - pts[j].first;
+			double c = (pts[j].second * pts[i].first) - (pts[i].second * pts[j].first);
+
+			// the rounding error of ax + by - c is at most bound, so only the points with
+			// values inside [-bound,bound] can be on the wrong side
+			double bound = LINE_ERRBOUND * (std::fabs(a) * soa.max_abs_x + std::fabs(b) * soa.max_abs_y
+				+ std::fabs(pts[j].second * pts[i].first) + std::fabs(pts[i].second * pts[j].first));
+
+			// finds which sides of the line from i to j the points are on
+			unsigned sides = line_sides(soa, a, b, c, bound);
+
+			// the points too close to the line may be on either side; this only happens
+			// for the few lines that do not clearly split the points
+			if(sides != LINE_BOTH)
+				sides = exact_line_sides(pts, i, j, a, b, c, bound);
+
+			// adds the line from i to j to the vector if all points are on the same side
+			if(sides != LINE_BOTH){
+				line_segment line;
+				line.first = pts[i];
+				line.second = pts[j];
+				ret_sgmts.push_back(line);
+			}
+		}
+	}
+}
+
+void brute_force_convex_hull(point_view pts, std::vector<line_segment> &ret_sgmts,
+	unsigned n_threads) {
+	hull_workspace ws;
+	brute_force_convex_hull(pts, ws, ret_sgmts, n_threads);
+}
+
+void brute_force_convex_hull(point_view pts, hull_workspace &ws, std::vector<line_segment> &ret_sgmts,
+	unsigned n_threads) {
+	// copies the points into separate x and y arrays for the line side kernel
+	point_soa &soa = ws.soa;
+	soa.assign(pts);
+	size_t n_rows = pts.size() - 1;
+
+	if(n_threads <= 1 || n_rows < 2) {
+		// loops through all the points except the last point
+		brute_force_rows(pts, soa, 0, n_rows, ret_sgmts);
+		return;
+	}
+
+	// row i holds n-1-i pairs; the rows are split into chunks holding about the same number of
+	// pairs, several per thread so the threads finishing early have more work to take
+	size_t n_chunks = std::min<size_t>(n_rows, 8 * (size_t)n_threads);
+	double n_pairs = 0.5 * (double)n_rows * (double)(n_rows + 1);
+	std::vector<size_t> bounds(1, 0);
+	double pairs = 0;
+	for(size_t i = 0; i < n_rows; i++) {
+		pairs += (double)(n_rows - i);
+		if(pairs >= n_pairs * (double)bounds.size() / (double)n_chunks && i + 1 < n_rows)
+			bounds.push_back(i + 1);
+	}
+	bounds.push_back(n_rows);
+	n_chunks = bounds.size() - 1;
+
+	// each chunk has its own buffer so the threads never share a vector
+	std::vector<std::vector<line_segment>> chunk_sgmts(n_chunks);
+	std::atomic<size_t> next_chunk(0);
+	std::vector<std::thread> threads;
+	for(unsigned t = 0; t < n_threads && t < n_chunks; t++) {
+		threads.push_back(std::thread([&]() {
+			size_t chunk;
+			while((chunk = next_chunk.fetch_add(1)) < n_chunks) {
+				brute_force_rows(pts, soa, bounds[chunk], bounds[chunk + 1], chunk_sgmts[chunk]);
+			}
+		}));
+	}
+	for(size_t t = 0; t < threads.size(); t++) {
+		threads[t].join();
+	}
+
+	// merges the buffers in chunk order so the segments are in the serial order
+	for(size_t chunk = 0; chunk < n_chunks; chunk++) {
+		ret_sgmts.insert(ret_sgmts.end(), chunk_sgmts[chunk].begin(), chunk_sgmts[chunk].end());
+	}
+}
+
+hull_algorithm parse_algorithm(const std::string &name) {
+	if(name == "brute") {
+		return BRUTE_FORCE;
+	}
+	else if(name == "monotone") {
+		return MONOTONE_CHAIN;
+	}
+	else if(name == "graham") {
+		return GRAHAM_SCAN;
+	}
+	else if(name == "quickhull") {
+		return QUICKHULL;
+	}
+	else if(name == "incremental") {
+		return INCREMENTAL;
+	}
+	std::ostringstream oss;
+	oss << name << ": unknown convex hull algorithm";
+	throw std::invalid_argument(oss.str());
+}
+
+const char * algorithm_name(hull_algorithm algorithm) {
+	switch(algorithm) {
+	case BRUTE_FORCE:
+		return "brute";
+	case MONOTONE_CHAIN:
+		return "monotone";
+	case GRAHAM_SCAN:
+		return "graham";
+	case QUICKHULL:
+		return "quickhull";
+	case INCREMENTAL:
+		return "incremental";
+	}
+	return "unknown";
+}
+
+double orientation(const point &p, const point &q, const point &r) {
+	double detleft = (q.first - p.first) * (r.second - p.second);
+	double detright = (q.second - p.second) * (r.first - p.first);
+	double det = detleft - detright;
+	double detsum;
+
+	// the signs of detleft and detright are always exact, so if they differ or one is 0 the
+	// sign of det is too
+	if(detleft > 0) {
+		if(detright <= 0)
+			return det;
+		detsum = detleft + detright;
+	}
+	else if(detleft < 0) {
+		if(detright >= 0)
+			return det;
+		detsum = -detleft - detright;
+	}
+	else {
+		return det;
+	}
+
+	// Shewchuk's error bound for the floating-point orientation test
+	const double ccw_errbound = (3.0 + 8.0 * DBL_EPSILON) * (DBL_EPSILON / 2);
+	if(det >= ccw_errbound * detsum || -det >= ccw_errbound * detsum)
+		return det;
+
+	return orientation_exact(p, q, r);
+}
+
+double orientation_exact(const point &p, const point &q, const point &r) {
+	n_exact_orientations.fetch_add(1, std::memory_order_relaxed);
+
+	// the cross product expanded into the six products of the coordinates
+	const double terms[6][2] = {
+		{q.first, r.second}, {-q.first, p.second}, {-p.first, r.second},
+		{-q.second, r.first}, {q.second, p.first}, {p.second, r.first}
+	};
+	double e[12];
+	size_t n = 0;
+	for(size_t i = 0; i < 6; i++) {
+		double product, err;
+		two_product(terms[i][0], terms[i][1], product, err);
+		n = grow_expansion(e, n, err);
+		n = grow_expansion(e, n, product);
+	}
+
+	// the largest component has the sign of the whole expansion
+	return n > 0 ? e[n - 1] : 0;
+}
+
+double line_distance_difference_exact(const point &p, const point &q, const point &r, const point &s) {
+	n_exact_orientations.fetch_add(1, std::memory_order_relaxed);
+
+	// the terms of orientation(p, q, r) and the negated ones of orientation(p, q, s); the two
+	// made of p and q alone cancel out
+	const double terms[8][2] = {
+		{q.first, r.second}, {-p.first, r.second}, {-q.second, r.first}, {p.second, r.first},
+		{-q.first, s.second}, {p.first, s.second}, {q.second, s.first}, {-p.second, s.first}
+	};
+	double e[16];
+	size_t n = 0;
+	for(size_t i = 0; i < 8; i++) {
+		double product, err;
+		two_product(terms[i][0], terms[i][1], product, err);
+		n = grow_expansion(e, n, err);
+		n = grow_expansion(e, n, product);
+	}
+
+	// the largest component has the sign of the whole expansion
+	return n > 0 ? e[n - 1] : 0;
+}
+
+void two_sum(double a, double b, double &ret_sum, double &ret_err) {
+	double x = a + b;
+	double b_virtual = x - a;
+	double a_virtual = x - b_virtual;
+	ret_err = (a - a_virtual) + (b - b_virtual);
+	ret_sum = x;
+}
+
+void two_product(double a, double b, double &ret_product, double &ret_err) {
+	double x = a * b;
+	ret_err = std::fma(a, b, -x);
+	ret_product = x;
+}
+
+size_t grow_expansion(double *e, size_t n, double b) {
+	double q = b;
+	size_t m = 0;
+	for(size_t i = 0; i < n; i++) {
+		double h;
+		two_sum(q, e[i], q, h);
+		if(h != 0)
+			e[m++] = h;
+	}
+	if(q != 0)
+		e[m++] = q;
+	return m;
+}
+
+void monotone_chain_convex_hull(point_view pts, std::vector<line_segment> &ret_sgmts) {
+	hull_workspace ws;
+	monotone_chain_convex_hull(pts, ws, ret_sgmts);
+}
+
+void monotone_chain_convex_hull(point_view pts, hull_workspace &ws, std::vector<line_segment> &ret_sgmts) {
+	// the sweep needs the points in lexicographical order without duplicates
+	point_view p = pts;
+	if(!std::is_sorted(pts.begin(), pts.end())) {
+		ws.pts.assign(pts.begin(), pts.end());
+		std::sort(ws.pts.begin(), ws.pts.end());
+		ws.pts.erase(std::unique(ws.pts.begin(), ws.pts.end()), ws.pts.end());
+		p = ws.pts;
+	}
+	size_t n = p.size();
+
+	// the lower hull followed by the upper hull; the first point is repeated at the end
+	std::vector<point> &chain = ws.chain;
+	chain.resize(2 * n);
+	size_t k = 0;
+
+	// builds the lower hull from the leftmost to the rightmost point
+	for(size_t i = 0; i < n; i++) {
+		// removes points making a clockwise turn; collinear points stay on the hull
+		while(k >= 2 && orientation(chain[k - 2], chain[k - 1], p[i]) < 0)
+			k--;
+		chain[k++] = p[i];
+	}
+
+	// builds the upper hull from the rightmost point back to the leftmost point
+	for(size_t i = n - 1, lower = k + 1; i > 0; i--) {
+		while(k >= lower && orientation(chain[k - 2], chain[k - 1], p[i - 1]) < 0)
+			k--;
+		chain[k++] = p[i - 1];
+	}
+
+	// adds the line between each pair of consecutive hull points
+	for(size_t i = 0; i + 1 < k; i++) {
+		ret_sgmts.push_back(line_segment(chain[i], chain[i + 1]));
+	}
+}
+
+void graham_scan_convex_hull(point_view pts, std::vector<line_segment> &ret_sgmts) {
+	hull_workspace ws;
+	graham_scan_convex_hull(pts, ws, ret_sgmts);
+}
+
+void graham_scan_convex_hull(point_view pts, hull_workspace &ws, std::vector<line_segment> &ret_sgmts) {
+	std::vector<point> &p = ws.pts;
+	p.assign(pts.begin(), pts.end());
+	std::sort(p.begin(), p.end());
+	p.erase(std::unique(p.begin(), p.end()), p.end());
+
+	// moves the lowest point (leftmost on ties) to the front to act as the pivot
+	std::iter_swap(p.begin(), std::min_element(p.begin(), p.end(),
+		[](const point &a, const point &b) {
+			return a.second < b.second || (a.second == b.second && a.first < b.first);
+		}));
+	const point pivot = p[0];
+
+	// sorts the remaining points counter-clockwise by polar angle, nearest first on ties
+	std::sort(p.begin() + 1, p.end(), [&pivot](const point &a, const point &b) {
+		double o = orientation(pivot, a, b);
+		if(o != 0)
+			return o > 0;
+		double da = (a.first - pivot.first) * (a.first - pivot.first) + (a.second - pivot.second) * (a.second - pivot.second);
+		double db = (b.first - pivot.first) * (b.first - pivot.first) + (b.second - pivot.second) * (b.second - pivot.second);
+		return da < db;
+	});
+
+	// points collinear with the pivot and the last point are visited on the way back to
+	// the pivot, so they have to be scanned farthest first
+	size_t last = p.size() - 1;
+	while(last > 1 && orientation(pivot, p[last - 1], p.back()) == 0)
+		last--;
+	if(last > 1)
+		std::reverse(p.begin() + last, p.end());
+
+	std::vector<point> &stack = ws.chain;
+	stack.clear();
+	for(size_t i = 0; i < p.size(); i++) {
+		// removes points making a clockwise turn; collinear points stay on the hull
+		while(stack.size() >= 2 && orientation(stack[stack.size() - 2], stack.back(), p[i]) < 0)
+			stack.pop_back();
+		stack.push_back(p[i]);
+	}
+
+	// adds the line between each pair of consecutive hull points and closes the polygon
+	for(size_t i = 0; i + 1 < stack.size(); i++) {
+		ret_sgmts.push_back(line_segment(stack[i], stack[i + 1]));
+	}
+	ret_sgmts.push_back(line_segment(stack.back(), stack.front()));
+}
+
+size_t akl_toussaint_filter(point_view pts, std::vector<point> &ret_pts) {
+	// indices of the extreme points in counter-clockwise order starting at the leftmost
+	// point: min x, min x+y, min y, max x-y, max x, max x+y, max y, min x-y
+	size_t extreme[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+	for(size_t i = 1; i < pts.size(); i++) {
+		double x = pts[i].first, y = pts[i].second;
+		const point &e0 = pts[extreme[0]], &e1 = pts[extreme[1]], &e2 = pts[extreme[2]],
+			&e3 = pts[extreme[3]], &e4 = pts[extreme[4]], &e5 = pts[extreme[5]],
+			&e6 = pts[extreme[6]], &e7 = pts[extreme[7]];
+		if(x < e0.first) extreme[0] = i;
+		if(x + y < e1.first + e1.second) extreme[1] = i;
+		if(y < e2.second) extreme[2] = i;
+		if(x - y > e3.first - e3.second) extreme[3] = i;
+		if(x > e4.first) extreme[4] = i;
+		if(x + y > e5.first + e5.second) extreme[5] = i;
+		if(y > e6.second) extreme[6] = i;
+		if(x - y < e7.first - e7.second) extreme[7] = i;
+	}
+
+	// removes repeated corners so every edge of the polygon has a direction
+	point polygon[8];
+	size_t n_corners = 0;
+	for(size_t i = 0; i < 8; i++) {
+		const point &pt = pts[extreme[i]];
+		if(n_corners == 0 || (polygon[n_corners - 1] != pt && polygon[0] != pt))
+			polygon[n_corners++] = pt;
+	}
+
+	// a polygon with less than 3 corners has no interior
+	if(n_corners < 3) {
+		std::copy(pts.begin(), pts.end(), std::back_inserter(ret_pts));
+		return 0;
+	}
+
+	size_t n_discarded = 0;
+	for(size_t i = 0; i < pts.size(); i++) {
+		// a point is inside the polygon if it is strictly left of every edge
+		bool inside = true;
+		for(size_t j = 0; j < n_corners && inside; j++) {
+			const point &next = polygon[(j + 1) % n_corners];
+			inside = orientation(polygon[j], next, pts[i]) > 0;
+		}
+		if(inside)
+			n_discarded++;
+		else
+			ret_pts.push_back(pts[i]);
+	}
+	return n_discarded;
+}
+
+void quickhull_helper(const point &p, const point &q, const point_soa &candidates,
+	std::vector<point> &on_line, std::deque<quickhull_level> &levels, size_t depth,
+	std::vector<line_segment> &ret_sgmts) {
+	if(candidates.empty()) {
+		// the line from p to q is an edge of the hull; the points lying on it are added in
+		// order of their distance from p
+		std::sort(on_line.begin(), on_line.end(), [&p](const point &a, const point &b) {
+			return std::fabs(a.first - p.first) + std::fabs(a.second - p.second)
+				< std::fabs(b.first - p.first) + std::fabs(b.second - p.second);
+		});
+		point prev = p;
+		for(size_t i = 0; i < on_line.size(); i++) {
+			ret_sgmts.push_back(line_segment(prev, on_line[i]));
+			prev = on_line[i];
+		}
+		ret_sgmts.push_back(line_segment(prev, q));
+		return;
+	}
+
+	// the deeper calls only add levels past this one, which a deque leaves in place
+	if(levels.size() <= depth)
+		levels.resize(depth + 1);
+	quickhull_level &level = levels[depth];
+
+	// finds the point farthest from the line from p to q; the values are rounded, so every
+	// candidate too close to the farthest one to tell them apart is compared with it exactly
+	std::vector<double> &dist = level.dist;
+	double bound = orientation_values(p, q, candidates, dist);
+	size_t farthest = std::max_element(dist.begin(), dist.end()) - dist.begin();
+	for(size_t i = 0; i < candidates.size(); i++) {
+		if(i != farthest && dist[i] >= dist[farthest] - 2 * bound
+			&& line_distance_difference_exact(p, q, candidates[i], candidates[farthest]) > 0)
+			farthest = i;
+	}
+	const point c = candidates[farthest];
+
+	// splits the points outside the triangle p, c, q between the edges p->c and c->q
+	std::vector<double> &o_pc = level.o_pc, &o_cq = level.o_cq;
+	orientation_values(p, c, candidates, o_pc);
+	orientation_values(c, q, candidates, o_cq);
+	point_soa &left_pc = level.left_pc, &left_cq = level.left_cq;
+	std::vector<point> &on_pc = level.on_pc, &on_cq = level.on_cq;
+	left_pc.clear();
+	left_cq.clear();
+	on_pc.clear();
+	on_cq.clear();
+	for(size_t i = 0; i < candidates.size(); i++) {
+		if(i == farthest)
+			continue;
+		if(o_pc[i] > 0) {
+			left_pc.push_back(candidates[i]);
+		}
+		else if(o_pc[i] == 0) {
+			on_pc.push_back(candidates[i]);
+		}
+		else if(o_cq[i] > 0) {
+			left_cq.push_back(candidates[i]);
+		}
+		else if(o_cq[i] == 0) {
+			on_cq.push_back(candidates[i]);
+		}
+	}
+
+	quickhull_helper(p, c, left_pc, on_pc, levels, depth + 1, ret_sgmts);
+	quickhull_helper(c, q, left_cq, on_cq, levels, depth + 1, ret_sgmts);
+}
+
+size_t quickhull_convex_hull(point_view pts, std::vector<line_segment> &ret_sgmts) {
+	hull_workspace ws;
+	return quickhull_convex_hull(pts, ws, ret_sgmts);
+}
+
+size_t quickhull_convex_hull(point_view pts, hull_workspace &ws, std::vector<line_segment> &ret_sgmts) {
+	std::vector<point> &filtered = ws.pts;
+	filtered.clear();
+	size_t n_discarded = akl_toussaint_filter(pts, filtered);
+
+	// the lexicographically smallest and largest points are always on the hull
+	std::vector<point>::const_iterator min_pt, max_pt;
+	std::tie(min_pt, max_pt) = std::minmax_element(filtered.begin(), filtered.end());
+	const point a = *min_pt, b = *max_pt;
+
+	// splits the points into those above, below and on the line from a to b
+	point_soa &soa = ws.soa, &upper = ws.upper, &lower = ws.lower;
+	std::vector<point> &on_ab = ws.on_ab;
+	std::vector<double> &o_ab = ws.o_ab;
+	soa.assign(filtered);
+	upper.clear();
+	lower.clear();
+	on_ab.clear();
+	orientation_values(a, b, soa, o_ab);
+	for(size_t i = 0; i < filtered.size(); i++) {
+		const point &pt = filtered[i];
+		if(pt == a || pt == b)
+			continue;
+		if(o_ab[i] > 0)
+			upper.push_back(pt);
+		else if(o_ab[i] < 0)
+			lower.push_back(pt);
+		else
+			on_ab.push_back(pt);
+	}
+
+	// the points on the line from a to b are only on the hull if one side is empty
+	std::vector<point> &on_ba = ws.on_ba;
+	on_ba.assign(on_ab.begin(), on_ab.end());
+	quickhull_helper(a, b, upper, on_ab, ws.levels, 0, ret_sgmts);
+	quickhull_helper(b, a, lower, on_ba, ws.levels, 0, ret_sgmts);
+
+	return n_discarded;
+}
+
+bool incremental_hull::inside_chain(const std::set<point> &chain, const point &pt, double sign) {
+	std::set<point>::const_iterator next = chain.upper_bound(pt);
+	if(next == chain.begin() || next == chain.end())
+		return false;
+	std::set<point>::const_iterator prev = std::prev(next);
+	return sign * orientation(*prev, *next, pt) > 0;
+}
+
+bool incremental_hull::insert_chain(std::set<point> &chain, const point &pt, double sign) {
+	if(inside_chain(chain, pt, sign))
+		return false;
+
+	std::pair<std::set<point>::iterator, bool> res = chain.insert(pt);
+	if(!res.second)
+		return false;
+	std::set<point>::iterator it = res.first;
+
+	// removes the points before pt that no longer turn the right way
+	while(it != chain.begin()) {
+		std::set<point>::iterator prev = std::prev(it);
+		if(prev == chain.begin() || sign * orientation(*std::prev(prev), *prev, pt) >= 0)
+			break;
+		chain.erase(prev);
+	}
+
+	// removes the points after pt that no longer turn the right way
+	while(true) {
+		std::set<point>::iterator next = std::next(it);
+		if(next == chain.end() || std::next(next) == chain.end()
+			|| sign * orientation(pt, *next, *std::next(next)) >= 0)
+			break;
+		chain.erase(next);
+	}
+	return true;
+}
+
+bool incremental_hull::insert(const point &pt) {
+	// points strictly inside both chains are inside the hull
+	if(inside_chain(lower_, pt, 1) && inside_chain(upper_, pt, -1))
+		return false;
+
+	bool on_lower = insert_chain(lower_, pt, 1);
+	bool on_upper = insert_chain(upper_, pt, -1);
+	return on_lower || on_upper;
+}
+
+size_t incremental_hull::insert_batch(point_view pts) {
+	size_t n_added = 0;
+	for(size_t i = 0; i < pts.size(); i++) {
+		if(insert(pts[i]))
+			n_added++;
+	}
+	return n_added;
+}
+
+std::vector<point> incremental_hull::vertices() const {
+	std::vector<point> pts;
+	std::set_union(lower_.begin(), lower_.end(), upper_.begin(), upper_.end(), std::back_inserter(pts));
+	return pts;
+}
+
+void incremental_hull::segments(std::vector<line_segment> &ret_sgmts) const {
+	if(lower_.size() == 1) {
+		ret_sgmts.push_back(line_segment(*lower_.begin(), *lower_.begin()));
+		return;
+	}
+	for(std::set<point>::const_iterator it = lower_.begin(); std::next(it) != lower_.end(); ++it) {
+		ret_sgmts.push_back(line_segment(*it, *std::next(it)));
+	}
+	for(std::set<point>::const_iterator it = upper_.begin(); std::next(it) != upper_.end(); ++it) {
+		ret_sgmts.push_back(line_segment(*it, *std::next(it)));
+	}
+}
+
+void incremental_convex_hull(point_view pts, std::vector<line_segment> &ret_sgmts) {
+	incremental_hull hull;
+	hull.insert_batch(pts);
+	hull.segments(ret_sgmts);
+}
+
+void stream_hull(std::istream &is, std::ostream &os) {
+	incremental_hull hull;
+	std::string line;
+	while(std::getline(is, line)) {
+		point pt;
+		std::istringstream iss(line);
+		if(!(iss >> std::ws).eof()) {
+			if(!(iss >> pt.first && iss >> pt.second) || !(iss >> std::ws).eof()) { // conversion error
+				std::ostringstream oss;
+				oss << "error reading point: " << line;
+				throw std::runtime_error(oss.str());
+			}
+			hull.insert(pt);
+		}
+		else if(!hull.empty()) { // blank line
+			std::vector<point> hull_pts = hull.vertices();
+			os << "Convex Hull (" << hull_pts.size() << " Points):" << std::endl;
+			os << hull_pts << std::endl;
+		}
+	}
+
+	// check if there was an error reading the stream
+	if(is.bad()) { // i/o error
+		std::ostringstream oss;
+		oss << "error reading points: " << strerror(errno);
+		throw std::runtime_error(oss.str());
+	}
+
+	std::vector<point> hull_pts = hull.vertices();
+	os << "Convex Hull (" << hull_pts.size() << " Points):" << std::endl;
+	os << hull_pts << std::endl;
+}
+
+void find_hull(point_view pts, std::vector<point> &ret_hull_points, hull_algorithm algorithm,
+	hull_stats *ret_stats, unsigned n_threads) {
+	hull_workspace ws;
+	find_hull(pts, ws, algorithm, ret_stats, n_threads);
+	std::copy(ws.hull_pts.begin(), ws.hull_pts.end(), std::back_inserter(ret_hull_points));
+}
+
+void find_hull(point_view pts, hull_workspace &ws, hull_algorithm algorithm,
+	hull_stats *ret_stats, unsigned n_threads) {
+	ws.hull_pts.clear();
+	if(pts.size() == 0) {
+		std::ostringstream oss;
+		oss << "error: one or more points are required to find the convex hull";
+		throw std::runtime_error(oss.str());
+	}
+	else if(pts.size() == 1) {
+		// the convex hull of a single point is the point itself
+		ws.hull_pts.push_back(*pts.begin());	
+	}
+	else {
+		hull_stats stats;
+		unsigned long long n_exact = n_exact_orientations.load();
+		ws.sgmts.clear();
+		switch(algorithm) {
+		case BRUTE_FORCE:
+			brute_force_convex_hull(pts, ws, ws.sgmts, n_threads);
+			break;
+		case MONOTONE_CHAIN:
+			monotone_chain_convex_hull(pts, ws, ws.sgmts);
+			break;
+		case GRAHAM_SCAN:
+			graham_scan_convex_hull(pts, ws, ws.sgmts);
+			break;
+		case QUICKHULL:
+			stats.n_discarded = quickhull_convex_hull(pts, ws, ws.sgmts);
+			break;
+		case INCREMENTAL:
+			incremental_convex_hull(pts, ws.sgmts);
+			break;
+		}
+		stats.n_exact = n_exact_orientations.load() - n_exact;
+
+		/* We need to copy the endpoints of the line segments to ws.hull_pts, but we
+		 * don't want duplicate points. Sorting the endpoints and removing the
+		 * duplicates in place gives the same order a std::set would without
+		 * allocating a node for every point.
+		 * */
+		std::transform(ws.sgmts.begin(), ws.sgmts.end(), std::back_inserter(ws.hull_pts), get_first);
+		std::transform(ws.sgmts.begin(), ws.sgmts.end(), std::back_inserter(ws.hull_pts), get_second);
+		std::sort(ws.hull_pts.begin(), ws.hull_pts.end());
+		ws.hull_pts.erase(std::unique(ws.hull_pts.begin(), ws.hull_pts.end()), ws.hull_pts.end());
+
+		if(ret_stats) {
+			*ret_stats = stats;
+		}
+	}
+}
+
+void read_point_sections(const std::string &filename, point_batch &ret_batch) {
+	point pt;
+	parse_status status = PARSE_OK;
+	mapped_file file(filename); // throws if there is an error opening the file
+	const char *first = file.begin();
+	size_t line_no = 0, section_line = 1;
+	size_t start = ret_batch.pts.size();
+
+	// sorts the current section, removes its duplicates and closes it off
+	auto end_section = [&]() {
+		if(ret_batch.pts.size() == start)
+			return;
+		std::sort(ret_batch.pts.begin() + start, ret_batch.pts.end());
+		ret_batch.pts.erase(std::unique(ret_batch.pts.begin() + start, ret_batch.pts.end()), ret_batch.pts.end());
+		ret_batch.offsets.push_back(ret_batch.pts.size());
+		ret_batch.names.push_back(filename + ":" + std::to_string(section_line));
+		start = ret_batch.pts.size();
+	};
+
+	while(first != file.end()) {
+		const char *last = std::find(first, file.end(), '\n');
+		line_no++;
+		if((status = parse_next(first, last, pt.first)) == PARSE_END) { // blank line
+			end_section();
+			section_line = line_no + 1;
+		}
+		else if(status == PARSE_ERROR || (status = parse_next(first, last, pt.second)) != PARSE_OK
+			|| parse_next(first, last, pt.first) != PARSE_END) { // conversion error
+			std::ostringstream oss;
+			oss << filename << ":" << line_no << ": error reading point";
+			throw std::runtime_error(oss.str());
+		}
+		else {
+			ret_batch.pts.push_back(pt);
+		}
+		first = (last == file.end()) ? last : last + 1;
+	}
+	end_section();
+}
+
+void read_point_manifest(const std::string &manifest, point_batch &ret_batch) {
+	std::ifstream ifs(manifest.c_str());
+	if(!ifs) {
+		std::ostringstream oss;
+		oss << manifest << ": " << strerror(errno);
+		throw std::runtime_error(oss.str());
+	}
+
+	std::string line;
+	while(std::getline(ifs, line)) {
+		// trims the whitespace around the file name
+		size_t begin = line.find_first_not_of(" \t\r");
+		if(begin == std::string::npos)
+			continue;
+		std::string filename = line.substr(begin, line.find_last_not_of(" \t\r") + 1 - begin);
+
+		if(is_point_cloud(filename)) {
+			point_cloud cloud(filename);
+			ret_batch.pts.insert(ret_batch.pts.end(), cloud.points().begin(), cloud.points().end());
+		}
+		else {
+			read_points(filename, ret_batch.pts);
+		}
+		ret_batch.offsets.push_back(ret_batch.pts.size());
+		ret_batch.names.push_back(filename);
+	}
+
+	if(ifs.bad()) { // i/o error
+		std::ostringstream oss;
+		oss << manifest << ": " << strerror(errno);
+		throw std::runtime_error(oss.str());
+	}
+}
+
+void find_hulls(const point_batch &batch, std::vector<point> &ret_hull_pts, std::vector<size_t> &ret_counts,
+	hull_algorithm algorithm, unsigned n_threads) {
+	// the sets are small, so the workers claim a few at a time to keep the counter cold
+	const size_t chunk_size = 16;
+	size_t n_sets = batch.size();
+	size_t n_chunks = (n_sets + chunk_size - 1) / chunk_size;
+	ret_hull_pts.resize(batch.pts.size());
+	ret_counts.assign(n_sets, 0);
+
+	std::atomic<size_t> next_chunk(0);
+	auto worker = [&]() {
+		hull_workspace ws;
+		size_t chunk;
+		while((chunk = next_chunk.fetch_add(1)) < n_chunks) {
+			for(size_t i = chunk * chunk_size; i < n_sets && i < (chunk + 1) * chunk_size; i++) {
+				if(batch.set(i).empty())
+					continue;
+				find_hull(batch.set(i), ws, algorithm);
+				std::copy(ws.hull_pts.begin(), ws.hull_pts.end(), ret_hull_pts.begin() + batch.offsets[i]);
+				ret_counts[i] = ws.hull_pts.size();
+			}
+		}
+	};
+
+	if(n_threads <= 1 || n_chunks < 2) {
+		worker();
+		return;
+	}
+
+	std::vector<std::thread> threads;
+	for(unsigned t = 0; t < n_threads && t < n_chunks; t++) {
+		threads.push_back(std::thread(worker));
+	}
+	for(size_t t = 0; t < threads.size(); t++) {
+		threads[t].join();
+	}
+}
+
+const char * distribution_name(point_distribution dist) {
+	switch(dist) {
+	case UNIFORM_SQUARE:
+		return "square";
+	case UNIFORM_DISK:
+		return "disk";
+	case ON_CIRCLE:
+		return "circle";
+	case GAUSSIAN:
+		return "gaussian";
+	}
+	return "unknown";
+}
+
+void generate_points(point_distribution dist, size_t n, std::mt19937_64 &rng, std::vector<point> &ret_pts) {
+	const double two_pi = 6.283185307179586;
+	std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+	std::normal_distribution<double> normal(0.0, 1.0);
+
+	ret_pts.clear();
+	ret_pts.reserve(n);
+	while(ret_pts.size() < n) {
+		point pt;
+		switch(dist) {
+		case UNIFORM_SQUARE:
+			pt = point(uniform(rng), uniform(rng));
+			break;
+		case UNIFORM_DISK:
+			// rejection sampling keeps the density uniform
+			do {
+				pt = point(uniform(rng), uniform(rng));
+			} while(pt.first * pt.first + pt.second * pt.second > 1.0);
+			break;
+		case ON_CIRCLE: {
+			double theta = two_pi * 0.5 * (uniform(rng) + 1.0);
+			pt = point(std::cos(theta), std::sin(theta));
+			break;
+		}
+		case GAUSSIAN:
+			pt = point(normal(rng), normal(rng));
+			break;
+		}
+		ret_pts.push_back(pt);
+	}
+
+	std::sort(ret_pts.begin(), ret_pts.end());
+	ret_pts.erase(std::unique(ret_pts.begin(), ret_pts.end()), ret_pts.end());
+}
+
+double percentile(std::vector<double> &samples, double pct) {
+	std::sort(samples.begin(), samples.end());
+	size_t rank = (size_t)std::ceil(pct / 100.0 * (double)samples.size());
+	return samples[rank > 0 ? rank - 1 : 0];
+}
+
+void run_benchmark(std::ostream &os, size_t max_n, unsigned n_reps, unsigned n_threads) {
+	const point_distribution dists[] = {UNIFORM_SQUARE, UNIFORM_DISK, ON_CIRCLE, GAUSSIAN};
+	const hull_algorithm algorithms[] = {BRUTE_FORCE, MONOTONE_CHAIN, GRAHAM_SCAN, QUICKHULL, INCREMENTAL};
+	const size_t max_brute_n = 1000;
+
+	os << "distribution,algorithm,n,hull_points,reps,median_us,p99_us,points_per_sec" << std::endl;
+	for(point_distribution dist : dists) {
+		for(size_t n = 100; n <= max_n; n *= 10) {
+			// every algorithm sees the same points
+			std::mt19937_64 rng(n);
+			std::vector<point> pts;
+			generate_points(dist, n, rng, pts);
+
+			for(hull_algorithm algorithm : algorithms) {
+				if(algorithm == BRUTE_FORCE && n > max_brute_n)
+					continue;
+
+				std::vector<double> times;
+				std::vector<point> hull_pts;
+				for(unsigned rep = 0; rep <= n_reps; rep++) {
+					hull_pts.clear();
+					std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+					find_hull(pts, hull_pts, algorithm, 0, n_threads);
+					std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+					// the first run only warms up the caches and the allocator
+					if(rep > 0)
+						times.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+				}
+
+				double median = percentile(times, 50);
+				double p99 = percentile(times, 99);
+				os << distribution_name(dist) << "," << algorithm_name(algorithm) << ","
+					<< pts.size() << "," << hull_pts.size() << "," << n_reps << ","
+					<< median << "," << p99 << ","
+					<< (median > 0 ? (double)pts.size() / (median * 1e-6) : 0) << std::endl;
+			}
+		}
+	}
+}
+
+int main (int argc, char *argv[]) {
+	hull_algorithm algorithm = MONOTONE_CHAIN;
+	unsigned n_threads = 1;
+	std::string convert_file;
+	bool stream = false;
+	bool benchmark = false;
+	std::string batch;
+	unsigned n_reps = 7;
+	size_t max_n = 1000000;
+	std::vector<std::string> args;
+
+	// separates the options from the positional arguments
+	for(int i = 1; i < argc; i++) {
+		std::string arg(argv[i]);
+		if(arg.compare(0, 12, "--algorithm=") == 0) {
+			try {
+				algorithm = parse_algorithm(arg.substr(12));
+			}
+			catch (std::exception &ex) {
+				std::cerr << ex.what() << std::endl << std::endl;
+				usage(argv[0]);
+				return 0;
+			}
+		}
+		else if(arg.compare(0, 10, "--threads=") == 0) {
+			int value;
+			std::istringstream iss(arg.substr(10));
+			if((iss >> value).fail() || !iss.eof() || value < 0) {
+				std::cerr << arg.substr(10) << " is not a valid number of threads." << std::endl << std::endl;
+				usage(argv[0]);
+				return 0;
+			}
+			n_threads = (value == 0) ? std::max(1u, std::thread::hardware_concurrency()) : (unsigned)value;
+		}
+		else if(arg.compare(0, 10, "--convert=") == 0) {
+			convert_file = arg.substr(10);
+		}
+		else if(arg == "--stream") {
+			stream = true;
+		}
+		else if(arg.compare(0, 8, "--batch=") == 0) {
+			batch = arg.substr(8);
+			if(batch != "sections" && batch != "manifest") {
+				std::cerr << "unknown batch input: " << batch << std::endl << std::endl;
+				usage(argv[0]);
+				return 0;
+			}
+		}
+		else if(arg == "--benchmark") {
+			benchmark = true;
+		}
+		else if(arg.compare(0, 7, "--reps=") == 0 || arg.compare(0, 8, "--max-n=") == 0) {
+			long value;
+			std::string str = arg.substr(arg.find('=') + 1);
+			std::istringstream iss(str);
+			if((iss >> value).fail() || !iss.eof() || value < 1) {
+				std::cerr << str << " is not a valid positive integer." << std::endl << std::endl;
+				usage(argv[0]);
+				return 0;
+			}
+			if(arg[2] == 'r')
+				n_reps = (unsigned)value;
+			else
+				max_n = (size_t)value;
+		}
+		else {
+			args.push_back(arg);
+		}
+	}
+
+	if(benchmark && args.empty()) {
+		run_benchmark(std::cout, max_n, n_reps, n_threads);
+	}
+	else if(benchmark) {
+		std::cerr << "Invalid number of arguments." << std::endl << std::endl;
+		usage(argv[0]);
+	}
+	else if(stream && args.empty()) {
+		try {
+			stream_hull(std::cin, std::cout);
+		}
+		catch (std::exception &ex) {
+			std::cerr << ex.what() << std::endl;
+		}
+	}
+	else if(stream || args.size() != 1) {
+		std::cerr << "Invalid number of arguments." << std::endl << std::endl;
+		usage(argv[0]);
+	}
+	else if(!batch.empty()) {
+		try {
+			struct timeval start_tv, end_tv;
+			point_batch sets;
+			std::vector<point> hull_pts;
+			std::vector<size_t> counts;
+
+			if(batch == "sections")
+				read_point_sections(args[0], sets);
+			else
+				read_point_manifest(args[0], sets);
+
+			gettimeofday(&start_tv, 0);
+			find_hulls(sets, hull_pts, counts, algorithm, n_threads);
+			gettimeofday(&end_tv, 0);
+
+			// the hulls are printed without flushing after every point
+			for(size_t i = 0; i < sets.size(); i++) {
+				std::cout << "Convex Hull of " << sets.names[i] << " (" << counts[i] << " Points):" << '\n';
+				for(size_t k = 0; k < counts[i]; k++)
+					std::cout << hull_pts[sets.offsets[i] + k] << '\n';
+			}
+			std::cout << "Point Sets: " << sets.size() << std::endl;
+			std::cout << "Elapsed Time (microseconds): "
+				<< (end_tv.tv_sec - start_tv.tv_sec)*1000000L + (end_tv.tv_usec - start_tv.tv_usec)
+				<< std::endl;
+		}
+		catch (std::exception &ex) {
+			std::cerr << ex.what() << std::endl;
+		}
+	}
+	else if(!convert_file.empty()) {
+		try {
+			std::vector<point> pts;
+			read_points(args[0], pts);
+			write_point_cloud(convert_file, pts);
+			std::cout << "Wrote " << pts.size() << " Points to " << convert_file << std::endl;
+		}
+		catch (std::exception &ex) {
+			std::cerr << ex.what() << std::endl;
+		}
+	}
+	else {
+		try {
+			struct timeval start_tv, end_tv;
+			std::string infile(args[0]);
+			std::vector<point> text_pts;
+			std::unique_ptr<point_cloud> cloud;
+			point_view pts;
+			std::vector<point> hull_pts;
+			hull_stats stats;
+
+			// binary point clouds are used in place, text files are parsed
+			if(is_point_cloud(infile)) {
+				cloud.reset(new point_cloud(infile));
+				pts = cloud->points();
+			}
+			else {
+				read_points(infile, text_pts);
+				pts = text_pts;
+			}
+			
+			gettimeofday(&start_tv, 0);
+			find_hull(pts, hull_pts, algorithm, &stats, n_threads);
+			gettimeofday(&end_tv, 0);
+
+			std::cout << "Convex Hull (" << hull_pts.size() << " Points):" << std::endl;
+			std::cout << hull_pts << std::endl;
+			std::cout << "Elapsed Time (microseconds): "
+				<< (end_tv.tv_sec - start_tv.tv_sec)*1000000L + (end_tv.tv_usec - start_tv.tv_usec)
+				<< std::endl;
+			std::cout << "Exact Orientation Tests: " << stats.n_exact << std::endl;
+			if(algorithm == QUICKHULL) {
+				std::cout << "Points Discarded by Prefilter: " << stats.n_discarded
+					<< " of " << pts.size() << std::endl;
+			}
 		}
 		catch (std::exception &ex) {
 			std::cerr << ex.what() << std::endl;
@@ -8,49 +8,1008 @@
 #include <sstream>
 #include <exception>
 #include <cmath>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
-void calculate_gcd(int m, int n)
-{
-    // Int to hold remainder, set equal m to make swapping easy if m < n
-    int r = m;
+#include <fcntl.h>
+#include <unistd.h>
 
-    // Printing the original numbers early since m and n might be changed
-    std::cout << "gcd(" << m << "," << n << ") ";
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GCD_X86_SIMD
+#endif
 
-    // To make sure neither number is negative
-    m = abs(m);
-    n = abs(n);
+// Count of trailing zeros of a nonzero unsigned word of any width up to 128 bits.
+template <typename U>
+inline int trailing_zeros(U x)
+{
+    if constexpr (sizeof(U) <= sizeof(unsigned int))
+    {
+        return __builtin_ctz(x);
+    }
+    else if constexpr (sizeof(U) <= sizeof(unsigned long long))
+    {
+        return __builtin_ctzll(x);
+    }
+    else
+    {
+        uint64_t low = (uint64_t)x;
+        return (low != 0) ? __builtin_ctzll(low) : 64 + __builtin_ctzll((uint64_t)(x >> 64));
+    }
+}
 
-    // To swap m and n
-    if (m < n)
+// Binary GCD (Stein's algorithm) of two unsigned words: the common factors of 2 are shifted
+// out once, then the larger odd number is replaced by the odd part of the difference until
+// they are equal. The difference has the same trailing zeros either way round, so they are
+// counted before the min and max are known. gcd(0, 0) is 0.
+template <typename U>
+U binary_gcd(U m, U n)
+{
+    if (m == 0 || n == 0)
     {
-        m = n;
-        n = r;
+        return m | n;
     }
 
-    // Euclid's algorithm
+    int shift = trailing_zeros<U>(m | n);
+    m >>= trailing_zeros(m);
+    n >>= trailing_zeros(n);
+    for (;;)
+    {
+        U difference = n - m;
+        if (difference == 0)
+        {
+            break;
+        }
+        int zeros = trailing_zeros(difference);
+        U low = std::min(m, n);
+        n = (U)((m > n) ? m - n : difference) >> zeros;
+        m = low;
+    }
+    return (U)(m << shift);
+}
+
+// Euclid's algorithm on two unsigned words with the hardware remainder.
+template <typename U>
+U euclid_gcd(U m, U n)
+{
     while (n != 0)
     {
-        r = m % n;
+        U r = m % n;
         m = n;
         n = r;
     }
+    return m;
+}
+
+// Arbitrary-precision unsigned integer: 64-bit limbs, least significant first, with no
+// leading zero limbs, so 0 has none. It has just enough arithmetic for gcd and ext_gcd.
+struct big_uint
+{
+    std::vector<uint64_t> limbs;
+
+    big_uint(uint64_t value = 0)
+    {
+        if (value != 0)
+        {
+            limbs.push_back(value);
+        }
+    }
+
+    // Parses a string of decimal digits.
+    explicit big_uint(const std::string &digits)
+    {
+        if (digits.empty())
+        {
+            throw std::runtime_error("empty string is not a valid integer.");
+        }
+        for (char c : digits)
+        {
+            if (c < '0' || c > '9')
+            {
+                throw std::runtime_error(digits + " is not a valid integer.");
+            }
+            multiply_add(10, c - '0');
+        }
+    }
+
+    bool is_zero() const
+    {
+        return limbs.empty();
+    }
+
+    size_t bit_length() const
+    {
+        return limbs.empty() ? 0 : 64 * limbs.size() - __builtin_clzll(limbs.back());
+    }
+
+    // The 64 bits starting at bit shift.
+    uint64_t bits_at(size_t shift) const
+    {
+        size_t limb = shift / 64, offset = shift % 64;
+        uint64_t bits = (limb < limbs.size()) ? limbs[limb] >> offset : 0;
+        if (offset != 0 && limb + 1 < limbs.size())
+        {
+            bits |= limbs[limb + 1] << (64 - offset);
+        }
+        return bits;
+    }
+
+    // *this = *this * factor + addend
+    void multiply_add(uint64_t factor, uint64_t addend)
+    {
+        unsigned __int128 carry = addend;
+        for (uint64_t &limb : limbs)
+        {
+            carry += (unsigned __int128)limb * factor;
+            limb = (uint64_t)carry;
+            carry >>= 64;
+        }
+        if (carry != 0)
+        {
+            limbs.push_back((uint64_t)carry);
+        }
+        trim();
+    }
+
+    // Divides *this by a nonzero word in place and returns the remainder.
+    uint64_t divide_word(uint64_t divisor)
+    {
+        unsigned __int128 rem = 0;
+        for (size_t i = limbs.size(); i-- > 0;)
+        {
+            rem = (rem << 64) | limbs[i];
+            limbs[i] = (uint64_t)(rem / divisor);
+            rem %= divisor;
+        }
+        trim();
+        return (uint64_t)rem;
+    }
+
+    std::string to_string() const
+    {
+        if (is_zero())
+        {
+            return "0";
+        }
+
+        // peel off 19 decimal digits at a time
+        big_uint rest = *this;
+        std::string digits;
+        while (!rest.is_zero())
+        {
+            std::string chunk = std::to_string(rest.divide_word(10000000000000000000ull));
+            if (!rest.is_zero())
+            {
+                chunk.insert(0, 19 - chunk.size(), '0');
+            }
+            digits.insert(0, chunk);
+        }
+        return digits;
+    }
+
+    void trim()
+    {
+        while (!limbs.empty() && limbs.back() == 0)
+        {
+            limbs.pop_back();
+        }
+    }
+};
+
+int compare(const big_uint &a, const big_uint &b)
+{
+    if (a.limbs.size() != b.limbs.size())
+    {
+        return (a.limbs.size() < b.limbs.size()) ? -1 : 1;
+    }
+    for (size_t i = a.limbs.size(); i-- > 0;)
+    {
+        if (a.limbs[i] != b.limbs[i])
+        {
+            return (a.limbs[i] < b.limbs[i]) ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+bool operator==(const big_uint &a, const big_uint &b)
+{
+    return a.limbs == b.limbs;
+}
+
+bool operator<(const big_uint &a, const big_uint &b)
+{
+    return compare(a, b) < 0;
+}
+
+big_uint operator+(const big_uint &a, const big_uint &b)
+{
+    const big_uint &longer = (a.limbs.size() >= b.limbs.size()) ? a : b;
+    const big_uint &shorter = (a.limbs.size() >= b.limbs.size()) ? b : a;
+    big_uint sum = longer;
+    unsigned __int128 carry = 0;
+
+    for (size_t i = 0; i < sum.limbs.size() && (i < shorter.limbs.size() || carry != 0); i++)
+    {
+        carry += (unsigned __int128)sum.limbs[i] + (i < shorter.limbs.size() ? shorter.limbs[i] : 0);
+        sum.limbs[i] = (uint64_t)carry;
+        carry >>= 64;
+    }
+    if (carry != 0)
+    {
+        sum.limbs.push_back((uint64_t)carry);
+    }
+    return sum;
+}
+
+// a - b, which must not be negative
+big_uint operator-(const big_uint &a, const big_uint &b)
+{
+    big_uint difference = a;
+    uint64_t borrow = 0;
+
+    for (size_t i = 0; i < difference.limbs.size() && (i < b.limbs.size() || borrow != 0); i++)
+    {
+        unsigned __int128 sub = (unsigned __int128)difference.limbs[i] - (i < b.limbs.size() ? b.limbs[i] : 0) - borrow;
+        difference.limbs[i] = (uint64_t)sub;
+        borrow = (uint64_t)(sub >> 64) & 1;
+    }
+    difference.trim();
+    return difference;
+}
+
+big_uint operator*(const big_uint &a, const big_uint &b)
+{
+    big_uint product;
+    if (a.is_zero() || b.is_zero())
+    {
+        return product;
+    }
+
+    product.limbs.assign(a.limbs.size() + b.limbs.size(), 0);
+    for (size_t i = 0; i < a.limbs.size(); i++)
+    {
+        unsigned __int128 carry = 0;
+        for (size_t j = 0; j < b.limbs.size(); j++)
+        {
+            carry += (unsigned __int128)a.limbs[i] * b.limbs[j] + product.limbs[i + j];
+            product.limbs[i + j] = (uint64_t)carry;
+            carry >>= 64;
+        }
+        product.limbs[i + b.limbs.size()] = (uint64_t)carry;
+    }
+    product.trim();
+    return product;
+}
+
+// Long division (Knuth's Algorithm D): the divisor is shifted so its top limb has its high
+// bit set, which keeps each trial quotient digit at most 2 too large.
+void divmod(const big_uint &a, const big_uint &b, big_uint &ret_q, big_uint &ret_r)
+{
+    if (b.is_zero())
+    {
+        throw std::runtime_error("division by zero");
+    }
+    if (a < b)
+    {
+        ret_q = big_uint();
+        ret_r = a;
+        return;
+    }
+    if (b.limbs.size() == 1)
+    {
+        ret_q = a;
+        ret_r = big_uint(ret_q.divide_word(b.limbs[0]));
+        return;
+    }
+
+    size_t n = b.limbs.size(), m = a.limbs.size() - n;
+    int s = __builtin_clzll(b.limbs.back());
+    std::vector<uint64_t> u(a.limbs.size() + 1), v(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        v[i] = (b.limbs[i] << s) | ((s != 0 && i > 0) ? b.limbs[i - 1] >> (64 - s) : 0);
+    }
+    for (size_t i = 0; i <= a.limbs.size(); i++)
+    {
+        uint64_t high = (i < a.limbs.size()) ? a.limbs[i] << s : 0;
+        u[i] = high | ((s != 0 && i > 0) ? a.limbs[i - 1] >> (64 - s) : 0);
+    }
+
+    ret_q.limbs.assign(m + 1, 0);
+    for (size_t j = m + 1; j-- > 0;)
+    {
+        unsigned __int128 numerator = ((unsigned __int128)u[j + n] << 64) | u[j + n - 1];
+        unsigned __int128 qhat = numerator / v[n - 1], rhat = numerator % v[n - 1];
+        while ((qhat >> 64) != 0 || qhat * v[n - 2] > ((rhat << 64) | u[j + n - 2]))
+        {
+            qhat--;
+            rhat += v[n - 1];
+            if ((rhat >> 64) != 0)
+            {
+                break;
+            }
+        }
+
+        // u[j..j+n] -= qhat * v
+        unsigned __int128 carry = 0;
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            carry += qhat * v[i];
+            unsigned __int128 sub = (unsigned __int128)u[i + j] - (uint64_t)carry - borrow;
+            u[i + j] = (uint64_t)sub;
+            borrow = (uint64_t)(sub >> 64) & 1;
+            carry >>= 64;
+        }
+        unsigned __int128 sub = (unsigned __int128)u[j + n] - carry - borrow;
+        u[j + n] = (uint64_t)sub;
+
+        // qhat was one too large: add v back
+        if ((sub >> 64) != 0)
+        {
+            qhat--;
+            carry = 0;
+            for (size_t i = 0; i < n; i++)
+            {
+                carry += (unsigned __int128)u[i + j] + v[i];
+                u[i + j] = (uint64_t)carry;
+                carry >>= 64;
+            }
+            u[j + n] += (uint64_t)carry;
+        }
+        ret_q.limbs[j] = (uint64_t)qhat;
+    }
+    ret_q.trim();
+
+    ret_r.limbs.assign(n, 0);
+    for (size_t i = 0; i < n; i++)
+    {
+        ret_r.limbs[i] = (u[i] >> s) | ((s != 0) ? u[i + 1] << (64 - s) : 0);
+    }
+    ret_r.trim();
+}
+
+std::ostream &operator<<(std::ostream &os, const big_uint &value)
+{
+    return os << value.to_string();
+}
+
+// Sign and magnitude, only for the coefficients ext_gcd returns for big_uint.
+struct big_int
+{
+    big_uint magnitude;
+    bool negative = false;
+};
+
+std::ostream &operator<<(std::ostream &os, const big_int &value)
+{
+    return os << ((value.negative && !value.magnitude.is_zero()) ? "-" : "") << value.magnitude;
+}
+
+// The types gcd and ext_gcd take, the magnitude type of the gcd, and the signed type of the
+// extended Euclid coefficients. The gcd of signed words is returned unsigned, since
+// gcd(INT_MIN, 0) does not fit in an int.
+template <typename T>
+struct gcd_traits;
+
+#define GCD_WORD_TRAITS(S, U)                      \
+    template <>                                    \
+    struct gcd_traits<S>                           \
+    {                                              \
+        static const bool is_word = true;          \
+        typedef U magnitude;                       \
+        typedef S coefficient;                     \
+    };                                             \
+    template <>                                    \
+    struct gcd_traits<U>                           \
+    {                                              \
+        static const bool is_word = true;          \
+        typedef U magnitude;                       \
+        typedef S coefficient;                     \
+    };
+
+GCD_WORD_TRAITS(signed char, unsigned char)
+GCD_WORD_TRAITS(short, unsigned short)
+GCD_WORD_TRAITS(int, unsigned int)
+GCD_WORD_TRAITS(long, unsigned long)
+GCD_WORD_TRAITS(long long, unsigned long long)
+GCD_WORD_TRAITS(__int128, unsigned __int128)
+
+#undef GCD_WORD_TRAITS
+
+template <>
+struct gcd_traits<big_uint>
+{
+    static const bool is_word = false;
+    typedef big_uint magnitude;
+    typedef big_int coefficient;
+};
+
+// Bezout coefficients: gcd = m * x + n * y
+template <typename T>
+struct ext_gcd_result
+{
+    typename gcd_traits<T>::magnitude gcd;
+    typename gcd_traits<T>::coefficient x;
+    typename gcd_traits<T>::coefficient y;
+};
+
+// |value| as the unsigned type of the same width, exact even for the most negative value.
+template <typename T>
+typename gcd_traits<T>::magnitude magnitude(T value)
+{
+    typedef typename gcd_traits<T>::magnitude U;
+    return (value < 0) ? (U)(U(0) - (U)value) : (U)value;
+}
+
+// One step of Lehmer's algorithm (Knuth's Algorithm L) on a >= b with b nonzero. Euclid runs
+// on the top 63 bits of a and the same bits of b for as long as the quotients are certain
+// to match the full ones, which gives the 2x2 matrix [A B; C D] of those steps. When no step
+// can be taken, ret_steps is 0 and the caller takes a full-precision step instead.
+void lehmer_matrix(const big_uint &a, const big_uint &b, int64_t &ret_a, int64_t &ret_b, int64_t &ret_c,
+                   int64_t &ret_d, int &ret_steps)
+{
+    size_t shift = (a.bit_length() > 63) ? a.bit_length() - 63 : 0;
+    __int128 ah = a.bits_at(shift), bh = b.bits_at(shift);
+    __int128 A = 1, B = 0, C = 0, D = 1;
+    const __int128 limit = INT64_MAX;
+
+    ret_steps = 0;
+    for (;;)
+    {
+        if (bh + C == 0 || bh + D == 0)
+        {
+            break;
+        }
+        __int128 q = (ah + A) / (bh + C);
+        if (q != (ah + B) / (bh + D))
+        {
+            break;
+        }
+
+        __int128 t_a = C, t_c = A - q * C, t_b = D, t_d = B - q * D;
+        if (t_c > limit || t_c < -limit || t_d > limit || t_d < -limit)
+        {
+            break;
+        }
+        A = t_a;
+        B = t_b;
+        C = t_c;
+        D = t_d;
+        __int128 t = ah - q * bh;
+        ah = bh;
+        bh = t;
+        ret_steps++;
+    }
+    ret_a = (int64_t)A;
+    ret_b = (int64_t)B;
+    ret_c = (int64_t)C;
+    ret_d = (int64_t)D;
+}
+
+// x * a + y * b for cofactors of opposite signs (or one zero) whose result is not negative,
+// so every partial sum fits in a signed 128-bit carry.
+big_uint linear_combination(int64_t x, const big_uint &a, int64_t y, const big_uint &b)
+{
+    big_uint result;
+    size_t size = std::max(a.limbs.size(), b.limbs.size());
+    __int128 carry = 0;
+
+    result.limbs.resize(size + 1);
+    for (size_t i = 0; i < size; i++)
+    {
+        carry += (__int128)x * (i < a.limbs.size() ? a.limbs[i] : 0);
+        carry += (__int128)y * (i < b.limbs.size() ? b.limbs[i] : 0);
+        result.limbs[i] = (uint64_t)carry;
+        carry >>= 64;
+    }
+    result.limbs[size] = (uint64_t)carry;
+    result.trim();
+    return result;
+}
+
+// x * a + y * b for words
+big_uint multiply_add(uint64_t x, const big_uint &a, uint64_t y, const big_uint &b)
+{
+    big_uint product_a = a, product_b = b;
+    product_a.multiply_add(x, 0);
+    product_b.multiply_add(y, 0);
+    return product_a + product_b;
+}
+
+// Lehmer's algorithm while a has more than one limb, then binary GCD on the last words.
+big_uint lehmer_gcd(big_uint a, big_uint b)
+{
+    if (a < b)
+    {
+        std::swap(a, b);
+    }
+    while (a.limbs.size() > 1 && !b.is_zero())
+    {
+        int64_t A, B, C, D;
+        int steps;
+        lehmer_matrix(a, b, A, B, C, D, steps);
+        if (steps == 0 || B == 0)
+        {
+            big_uint q, r;
+            divmod(a, b, q, r);
+            a = std::move(b);
+            b = std::move(r);
+        }
+        else
+        {
+            big_uint next_a = linear_combination(A, a, B, b);
+            b = linear_combination(C, a, D, b);
+            a = std::move(next_a);
+        }
+    }
+    if (b.is_zero())
+    {
+        return a;
+    }
+    uint64_t m = a.is_zero() ? 0 : a.limbs[0], n = b.is_zero() ? 0 : b.limbs[0];
+    return big_uint(binary_gcd(m, n));
+}
+
+// Extended Lehmer. Euclid's coefficients of a alternate in sign, so only their magnitudes
+// are kept (x0 for a, x1 for b) with the sign of x0 flipping every step, and each matrix
+// step adds x0' = |A| x0 + |B| x1. The coefficient of the smaller number is recovered at the
+// end by one exact division.
+ext_gcd_result<big_uint> lehmer_ext_gcd(const big_uint &m, const big_uint &n)
+{
+    bool swapped = m < n;
+    const big_uint &a0 = swapped ? n : m, &b0 = swapped ? m : n;
+    big_uint a = a0, b = b0, x0(1), x1(0);
+    bool x0_negative = false;
+
+    while (!b.is_zero())
+    {
+        int64_t A, B, C, D;
+        int steps = 0;
+        if (a.limbs.size() > 1)
+        {
+            lehmer_matrix(a, b, A, B, C, D, steps);
+        }
+        if (steps == 0 || B == 0)
+        {
+            big_uint q, r;
+            divmod(a, b, q, r);
+            a = std::move(b);
+            b = std::move(r);
+            big_uint next_x1 = x0 + q * x1;
+            x0 = std::move(x1);
+            x1 = std::move(next_x1);
+            x0_negative = !x0_negative;
+        }
+        else
+        {
+            big_uint next_a = linear_combination(A, a, B, b);
+            b = linear_combination(C, a, D, b);
+            a = std::move(next_a);
+            big_uint next_x0 = multiply_add(magnitude(A), x0, magnitude(B), x1);
+            x1 = multiply_add(magnitude(C), x0, magnitude(D), x1);
+            x0 = std::move(next_x0);
+            x0_negative ^= (steps % 2 != 0);
+        }
+    }
+
+    // y = (gcd - a0 x) / b0
+    ext_gcd_result<big_uint> result;
+    result.gcd = a;
+    result.x.magnitude = x0;
+    result.x.negative = x0_negative && !x0.is_zero();
+    if (!b0.is_zero())
+    {
+        big_uint product = a0 * x0, remainder;
+        if (result.x.negative)
+        {
+            divmod(a + product, b0, result.y.magnitude, remainder);
+        }
+        else if (product < a)
+        {
+            divmod(a - product, b0, result.y.magnitude, remainder);
+        }
+        else
+        {
+            divmod(product - a, b0, result.y.magnitude, remainder);
+            result.y.negative = !result.y.magnitude.is_zero();
+        }
+    }
+    if (swapped)
+    {
+        std::swap(result.x, result.y);
+    }
+    return result;
+}
+
+// Greatest common divisor of any integer type gcd_traits knows, returned by value and never
+// negative; gcd(0, 0) is 0. Words up to 64 bits use Euclid, since the hardware division beat
+// binary GCD on them; 128-bit words have no hardware division, so they use binary GCD unless
+// both fit in 64 bits. big_uint uses Lehmer's algorithm.
+template <typename T>
+typename gcd_traits<T>::magnitude gcd(T m, T n)
+{
+    if constexpr (gcd_traits<T>::is_word)
+    {
+        typedef typename gcd_traits<T>::magnitude U;
+        U a = magnitude(m), b = magnitude(n);
+        if constexpr (sizeof(U) > sizeof(uint64_t))
+        {
+            if (((a | b) >> 64) == 0)
+            {
+                return euclid_gcd((uint64_t)a, (uint64_t)b);
+            }
+            return binary_gcd(a, b);
+        }
+        else
+        {
+            return euclid_gcd(a, b);
+        }
+    }
+    else
+    {
+        return lehmer_gcd(m, n);
+    }
+}
 
-    if (m == 0)
+// Extended Euclid: the gcd and coefficients with m * x + n * y = gcd, where |x| <= |n| / gcd
+// and |y| <= |m| / gcd, so they fit in the signed type. Words run Euclid with the hardware
+// division, computing the coefficients modulo 2^width so no intermediate can overflow, and
+// 128-bit words are narrowed to 64 bits when both fit; big_uint uses extended Lehmer.
+// A modular inverse of m modulo n is x when the gcd is 1.
+template <typename T>
+ext_gcd_result<T> ext_gcd(T m, T n)
+{
+    if constexpr (gcd_traits<T>::is_word)
+    {
+        typedef typename gcd_traits<T>::magnitude U;
+        typedef typename gcd_traits<T>::coefficient S;
+        ext_gcd_result<T> result;
+        U a = magnitude(m), b = magnitude(n);
+
+        if constexpr (sizeof(U) > sizeof(uint64_t))
+        {
+            if (((a | b) >> 64) == 0)
+            {
+                ext_gcd_result<uint64_t> narrow = ext_gcd((uint64_t)a, (uint64_t)b);
+                result.gcd = narrow.gcd;
+                result.x = narrow.x;
+                result.y = narrow.y;
+                result.x = (m < 0) ? -result.x : result.x;
+                result.y = (n < 0) ? -result.y : result.y;
+                return result;
+            }
+        }
+
+        // at least unsigned int, so the narrow types are not promoted to int and overflow
+        typedef decltype(U(0) + 0u) W;
+        W r0 = a, r1 = b, x0 = 1, x1 = 0, y0 = 0, y1 = 1;
+        while (r1 != 0)
+        {
+            W q = r0 / r1, t = r0 - q * r1;
+            r0 = r1;
+            r1 = t;
+            t = x0 - q * x1;
+            x0 = x1;
+            x1 = t;
+            t = y0 - q * y1;
+            y0 = y1;
+            y1 = t;
+        }
+        result.gcd = (U)r0;
+        result.x = (S)x0;
+        result.y = (S)y0;
+        result.x = (m < 0) ? -result.x : result.x;
+        result.y = (n < 0) ? -result.y : result.y;
+        return result;
+    }
+    else
+    {
+        return lehmer_ext_gcd(m, n);
+    }
+}
+
+void calculate_gcd(int m, int n)
+{
+    // Printing the original numbers
+    std::cout << "gcd(" << m << "," << n << ") ";
+
+    // Unsigned, since gcd(INT_MIN, 0) does not fit in an int
+    unsigned int g = gcd(m, n);
+
+    if (g == 0)
     {
         std::cout << "is undefined" << std::endl;
     }
     else
     {
-        std::cout << "= " << m << std::endl;
+        std::cout << "= " << g << std::endl;
+    }
+}
+
+void gcd_scalar(const uint32_t *a, const uint32_t *b, uint32_t *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = binary_gcd(a[i], b[i]);
+    }
+}
+
+#ifdef GCD_X86_SIMD
+// The lanes run the same steps as binary_gcd. AVX2 has no count of trailing zeros, so the
+// lowest set bit is isolated and its exponent read back from a float conversion; a lane
+// whose b is already 0 is left alone until every lane is done.
+__attribute__((target("avx2")))
+inline __m256i ctz_epi32_avx2(__m256i x)
+{
+    __m256i low = _mm256_and_si256(x, _mm256_sub_epi32(_mm256_setzero_si256(), x));
+    __m256i exponent = _mm256_srli_epi32(_mm256_castps_si256(_mm256_cvtepi32_ps(low)), 23);
+    return _mm256_sub_epi32(_mm256_and_si256(exponent, _mm256_set1_epi32(0xFF)), _mm256_set1_epi32(127));
+}
+
+__attribute__((target("avx2")))
+void gcd_avx2(const uint32_t *a, const uint32_t *b, uint32_t *out, size_t n)
+{
+    const __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi32(1);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i m = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i k = _mm256_loadu_si256((const __m256i *)(b + i));
+
+        // a lane with a zero is done already; it is given 1s so the loop leaves it alone
+        __m256i has_zero = _mm256_or_si256(_mm256_cmpeq_epi32(m, zero), _mm256_cmpeq_epi32(k, zero));
+        __m256i either = _mm256_or_si256(m, k);
+        m = _mm256_blendv_epi8(m, one, has_zero);
+        k = _mm256_blendv_epi8(k, one, has_zero);
+
+        __m256i shift = ctz_epi32_avx2(_mm256_or_si256(m, k));
+        m = _mm256_srlv_epi32(m, ctz_epi32_avx2(m));
+        for (;;)
+        {
+            __m256i done = _mm256_cmpeq_epi32(k, zero);
+            if (_mm256_movemask_epi8(done) == -1)
+            {
+                break;
+            }
+            // k is odd after the shift and 0 stays 0, since the count is out of range
+            k = _mm256_srlv_epi32(k, ctz_epi32_avx2(k));
+            __m256i low = _mm256_min_epu32(m, k);
+            k = _mm256_andnot_si256(done, _mm256_sub_epi32(_mm256_max_epu32(m, k), low));
+            m = _mm256_blendv_epi8(low, m, done);
+        }
+        m = _mm256_sllv_epi32(m, shift);
+        _mm256_storeu_si256((__m256i *)(out + i), _mm256_blendv_epi8(m, either, has_zero));
+    }
+    gcd_scalar(a + i, b + i, out + i, n - i);
+}
+
+// The same steps as gcd_avx2 on 16 lanes, with the count of trailing zeros found from the
+// count of leading zeros of AVX-512CD and masks instead of blends. GCC 12 warns that the
+// unmasked AVX-512 intrinsics read an uninitialized __Y; that is the _mm512_undefined_epi32()
+// they pass as the source of the lanes they overwrite anyway.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f,avx512cd")))
+inline __m512i ctz_epi32_avx512(__m512i x)
+{
+    __m512i low = _mm512_and_si512(x, _mm512_sub_epi32(_mm512_setzero_si512(), x));
+    return _mm512_sub_epi32(_mm512_set1_epi32(31), _mm512_lzcnt_epi32(low));
+}
+
+__attribute__((target("avx512f,avx512cd")))
+void gcd_avx512(const uint32_t *a, const uint32_t *b, uint32_t *out, size_t n)
+{
+    const __m512i zero = _mm512_setzero_si512(), one = _mm512_set1_epi32(1);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m512i m = _mm512_loadu_si512(a + i);
+        __m512i k = _mm512_loadu_si512(b + i);
+
+        __mmask16 has_zero = _mm512_cmpeq_epi32_mask(m, zero) | _mm512_cmpeq_epi32_mask(k, zero);
+        __m512i either = _mm512_or_si512(m, k);
+        m = _mm512_mask_mov_epi32(m, has_zero, one);
+        k = _mm512_mask_mov_epi32(k, has_zero, one);
+
+        __m512i shift = ctz_epi32_avx512(_mm512_or_si512(m, k));
+        m = _mm512_srlv_epi32(m, ctz_epi32_avx512(m));
+        for (;;)
+        {
+            __mmask16 active = _mm512_cmpneq_epi32_mask(k, zero);
+            if (active == 0)
+            {
+                break;
+            }
+            k = _mm512_mask_srlv_epi32(k, active, k, ctz_epi32_avx512(k));
+            __m512i low = _mm512_min_epu32(m, k);
+            k = _mm512_mask_sub_epi32(k, active, _mm512_max_epu32(m, k), low);
+            m = _mm512_mask_mov_epi32(m, active, low);
+        }
+        m = _mm512_sllv_epi32(m, shift);
+        _mm512_storeu_si512(out + i, _mm512_mask_mov_epi32(m, has_zero, either));
+    }
+    gcd_scalar(a + i, b + i, out + i, n - i);
+}
+#pragma GCC diagnostic pop
+#endif
+
+typedef void (*gcd_kernel)(const uint32_t *, const uint32_t *, uint32_t *, size_t);
+
+// Picks the widest kernel the processor supports.
+gcd_kernel select_gcd_kernel()
+{
+#ifdef GCD_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512cd"))
+    {
+        return gcd_avx512;
+    }
+    else if (__builtin_cpu_supports("avx2"))
+    {
+        return gcd_avx2;
+    }
+#endif
+    return gcd_scalar;
+}
+
+// Computes out[i] = gcd(a[i], b[i]) for n pairs with binary GCD, 16 or 8 pairs at a time
+// with AVX-512 or AVX2 when the processor has them. The pairs are split into n_threads
+// equal slices that are computed at the same time.
+void gcd_batch(const uint32_t *a, const uint32_t *b, uint32_t *out, size_t n, unsigned n_threads = 1)
+{
+    static const gcd_kernel kernel = select_gcd_kernel();
+    std::vector<std::thread> threads;
+
+    n_threads = std::max(1u, n_threads);
+    for (unsigned t = 1; t < n_threads; t++)
+    {
+        size_t first = n * t / n_threads, last = n * (t + 1) / n_threads;
+        threads.push_back(std::thread(kernel, a + first, b + first, out + first, last - first));
+    }
+    kernel(a, b, out, n / n_threads);
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+// Reads all of a file, or stdin if filename is "-", into a string.
+std::string read_input(const std::string &filename)
+{
+    int fd = (filename == "-") ? 0 : open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error(filename + ": " + std::strerror(errno));
+    }
+
+    std::string data;
+    size_t size = 0;
+    for (;;)
+    {
+        data.resize(std::max<size_t>(1 << 16, 2 * size));
+        ssize_t n_read = read(fd, &data[size], data.size() - size);
+        if (n_read < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n_read < 0)
+        {
+            std::string error = filename + ": " + std::strerror(errno);
+            if (fd != 0)
+            {
+                close(fd);
+            }
+            throw std::runtime_error(error);
+        }
+        if (n_read == 0)
+        {
+            break;
+        }
+        size += n_read;
+    }
+    if (fd != 0)
+    {
+        close(fd);
+    }
+    data.resize(size);
+    return data;
+}
+
+// Parses whitespace separated pairs of integers into the absolute values of their first and
+// second numbers; the absolute value of INT_MIN fits in a uint32_t.
+void parse_pairs(const std::string &data, const std::string &filename, std::vector<uint32_t> &ret_a,
+                 std::vector<uint32_t> &ret_b)
+{
+    const char *pos = data.data(), *end = data.data() + data.size();
+    size_t n_numbers = 0;
+
+    ret_a.clear();
+    ret_b.clear();
+    for (;;)
+    {
+        while (pos != end && std::isspace((unsigned char)*pos))
+        {
+            pos++;
+        }
+        if (pos == end)
+        {
+            break;
+        }
+
+        int value;
+        std::from_chars_result result = std::from_chars(pos, end, value);
+        if (result.ec != std::errc() || (result.ptr != end && !std::isspace((unsigned char)*result.ptr)))
+        {
+            const char *token_end = std::find_if(pos, end, [](char c) { return std::isspace((unsigned char)c); });
+            throw std::runtime_error(filename + ": " + std::string(pos, token_end) + " is not a valid integer.");
+        }
+        pos = result.ptr;
+
+        uint32_t magnitude = (value < 0) ? 0u - (uint32_t)value : (uint32_t)value;
+        (n_numbers++ % 2 == 0 ? ret_a : ret_b).push_back(magnitude);
+    }
+    if (n_numbers % 2 != 0)
+    {
+        throw std::runtime_error(filename + ": odd number of integers");
     }
 }
 
+// Writes one result per line to stdout through a large buffer with to_chars and write.
+void write_results(const std::vector<uint32_t> &results)
+{
+    const size_t flush_size = 1 << 20;
+    std::vector<char> buffer(flush_size + 16);
+    char *pos = buffer.data();
+
+    auto flush = [&]()
+    {
+        for (const char *first = buffer.data(); first != pos;)
+        {
+            ssize_t n_written = write(1, first, pos - first);
+            if (n_written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n_written < 0)
+            {
+                throw std::runtime_error(std::string("stdout: ") + std::strerror(errno));
+            }
+            first += n_written;
+        }
+        pos = buffer.data();
+    };
+
+    for (uint32_t result : results)
+    {
+        pos = std::to_chars(pos, buffer.data() + buffer.size(), result).ptr;
+        *pos++ = '\n';
+        if ((size_t)(pos - buffer.data()) >= flush_size)
+        {
+            flush();
+        }
+    }
+    flush();
+}
+
 void usage(char *name)
 {
     std::cerr << "Calculates the greatest common divisor of two numbers." << std::endl;
     std::cerr << "usage:" << name << " [m] [n]" << std::endl;
+    std::cerr << "      " << name << " --batch [--threads=t] [file]" << std::endl;
     std::cerr << "m,n integers, not both zero" << std::endl;
+    std::cerr << "--batch reads pairs of integers from file, or stdin if it is - or missing, and" << std::endl;
+    std::cerr << "        prints the gcd of each pair on its own line, 0 if both are zero" << std::endl;
+    std::cerr << "--threads number of threads to use; 0 uses every core (default: 1)" << std::endl;
 }
 
 int main(int argc, char *argv[])
@@ -58,6 +1017,60 @@ int main(int argc, char *argv[])
     int m = 0;
     int n = 0;
 
+    if (argc >= 2 && std::string(argv[1]) == "--batch")
+    {
+        unsigned n_threads = 1;
+        std::string filename = "-";
+        int n_files = 0;
+        for (int i = 2; i < argc; i++)
+        {
+            std::string arg(argv[i]);
+            if (arg.compare(0, 10, "--threads=") == 0)
+            {
+                int value;
+                std::istringstream iss(arg.substr(10));
+                if ((iss >> value).fail() || !iss.eof() || value < 0)
+                {
+                    std::cerr << arg.substr(10) << " is not a valid number of threads." << std::endl
+                              << std::endl;
+                    usage(argv[0]);
+
+                    return 0;
+                }
+                n_threads = (value == 0) ? std::max(1u, std::thread::hardware_concurrency()) : (unsigned)value;
+            }
+            else
+            {
+                filename = arg;
+                n_files++;
+            }
+        }
+        if (n_files > 1)
+        {
+            std::cerr << "Invalid number of arguments." << std::endl
+                      << std::endl;
+            usage(argv[0]);
+
+            return 0;
+        }
+
+        try
+        {
+            std::vector<uint32_t> a, b;
+            parse_pairs(read_input(filename), filename, a, b);
+            std::vector<uint32_t> results(a.size());
+            gcd_batch(a.data(), b.data(), results.data(), a.size(), n_threads);
+            write_results(results);
+        }
+        catch (std::exception &ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
     if (argc != 3)
     {
         std::cerr << "Invalid number of arguments." << std::endl
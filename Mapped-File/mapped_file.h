@@ -0,0 +1,164 @@
+/*
+	Title:    mapped_file.h
+	Purpose:  Memory-mapped input files and the in-place number parser shared by the programs
+*/
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <charconv>
+#include <cstddef>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Memory-mapped file.
+ *
+ * This class maps a file into memory for the lifetime of the object so it can be parsed in
+ * place without copying it through a stream buffer. An empty file is represented by an empty
+ * range. The mapping is read-only unless it is made copy-on-write, in which case changes are
+ * private to the process and never written back to the file.
+ * */
+class mapped_file {
+public:
+	/* Maps filename into memory.
+	 *
+	 * @param filename - name of the file to map
+	 * @param copy_on_write - if true the mapped pages may be modified through data()
+	 *
+	 * @throws std::runtime_error - thrown if the file can not be opened or mapped
+	 * */
+	explicit mapped_file(const std::string &filename, bool copy_on_write = false);
+	~mapped_file();
+
+	mapped_file(const mapped_file &) = delete;
+	mapped_file & operator=(const mapped_file &) = delete;
+
+	char * data() { return data_; }
+	const char * begin() const { return data_; }
+	const char * end() const { return data_ + size_; }
+	std::size_t size() const { return size_; }
+
+	/* Releases the pages holding [first, last).
+	 *
+	 * The pages are dropped from the process and read back from the file if they are read
+	 * again, so a file larger than memory can be processed a window at a time.
+	 * */
+	void release(const char *first, const char *last);
+
+private:
+	char *data_;
+	std::size_t size_;
+};
+
+/* Result of parse_next.
+ *
+ * PARSE_OK if a value was read, PARSE_END if only whitespace was left and PARSE_ERROR if the
+ * next characters are not a valid value.
+ * */
+enum parse_status { PARSE_OK, PARSE_END, PARSE_ERROR };
+
+/* Parses the next value of a buffer.
+ *
+ * This function skips the whitespace at first and converts the characters that follow to a
+ * T using std::from_chars. On success first is moved past the characters read. A leading '+'
+ * is accepted the same way operator>> accepts it. A floating-point value that is not finite
+ * ("nan", "inf" or "infinity") is a PARSE_ERROR.
+ *
+ * @param first - the beginning of the characters left to parse
+ * @param last - the end of the buffer
+ * @param ret_value - the value read is stored here
+ *
+ * @return the parse_status of the conversion
+ * */
+template <typename T>
+parse_status parse_next(const char *&first, const char *last, T &ret_value);
+
+
+
+
+
+
+inline mapped_file::mapped_file(const std::string &filename, bool copy_on_write) : data_(0), size_(0) {
+	int fd = open(filename.c_str(), O_RDONLY);
+	struct stat st;
+	if(fd < 0 || fstat(fd, &st) < 0) {
+		std::ostringstream oss;
+		oss << filename << ": " << strerror(errno);
+		if(fd >= 0) {
+			close(fd);
+		}
+		throw std::runtime_error(oss.str());
+	}
+
+	size_ = st.st_size;
+	if(size_ > 0) {
+		int prot = copy_on_write ? (PROT_READ | PROT_WRITE) : PROT_READ;
+		void *addr = mmap(0, size_, prot, MAP_PRIVATE, fd, 0);
+		if(addr == MAP_FAILED) {
+			std::ostringstream oss;
+			oss << filename << ": " << strerror(errno);
+			close(fd);
+			throw std::runtime_error(oss.str());
+		}
+		data_ = static_cast<char *>(addr);
+		madvise(addr, size_, MADV_SEQUENTIAL);
+	}
+	close(fd);
+}
+
+inline mapped_file::~mapped_file() {
+	if(data_) {
+		munmap(data_, size_);
+	}
+}
+
+inline void mapped_file::release(const char *first, const char *last) {
+	// madvise only takes whole pages; the page holding last may still be needed
+	std::size_t page_size = sysconf(_SC_PAGESIZE);
+	std::size_t begin = (first - data_) / page_size * page_size;
+	std::size_t end = (last - data_) / page_size * page_size;
+	if(end > begin) {
+		madvise(data_ + begin, end - begin, MADV_DONTNEED);
+	}
+}
+
+template <typename T>
+parse_status parse_next(const char *&first, const char *last, T &ret_value) {
+	while(first != last && std::isspace(static_cast<unsigned char>(*first))) {
+		++first;
+	}
+	if(first == last) {
+		return PARSE_END;
+	}
+
+	const char *start = first;
+	if(*start == '+' && start + 1 != last && *(start + 1) != '-') {
+		++start;
+	}
+	std::from_chars_result result = std::from_chars(start, last, ret_value);
+	if(result.ec != std::errc()) {
+		return PARSE_ERROR;
+	}
+	// from_chars spells out nan and inf, which operator>> rejects
+	if constexpr (std::is_floating_point<T>::value) {
+		if(!std::isfinite(ret_value)) {
+			return PARSE_ERROR;
+		}
+	}
+	first = result.ptr;
+	return PARSE_OK;
+}
+
+#endif
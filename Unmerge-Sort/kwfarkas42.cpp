@@ -4,13 +4,38 @@
  *  Date:    November 14, 2022
  *  Purpose: To unmerge a sorted array into the worst-case input for merge-sort
  */
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <exception>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include <cerrno>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define UNMERGE_X86_SIMD
+#endif
 
 /* Prints a standard container.
  *
@@ -56,6 +81,126 @@ void unmerge_sort_helper(std::vector<int> &items, size_t l, size_t r);
  * */
 void unmerge_sort(std::vector<int> &items);
 
+/* Unmerge index.
+ *
+ * This function finds the position of the sorted array that unmerge_sort moves to position
+ * p of an array of n items, without moving anything. An array of n > 1 items is split into
+ * a left half of ceil(n/2) items taken from the even positions and a right half taken from
+ * the odd positions, so while walking down from the top to the half holding p, the k-th
+ * choice of the right half sets bit k of the position. It takes O(log n) time.
+ *
+ * @param p - the position in the unmerged array, less than n
+ * @param n - the number of items
+ *
+ * @return the position in the sorted array of the item unmerge_sort stores at p
+ * */
+size_t unmerge_index(size_t p, size_t n);
+
+/* Direct unmerge sort.
+ *
+ * This function rearranges a sorted array into the same worst-case input for merge sort
+ * as unmerge_sort, without recursion and with a single copy of items as the only
+ * allocation. The halves unmerge_sort would recurse into are visited with a small fixed
+ * stack in the order they appear in the output, carrying the bits unmerge_index would find
+ * for them, so each of the 2n-1 halves is handled once and the array is filled in one O(n)
+ * pass.
+ *
+ * @param items - reference to the list of integers to be "unsorted"
+ * */
+void direct_unmerge_sort(std::vector<int> &items);
+
+/* Unmerge stream.
+ *
+ * This class produces the worst-case input unmerge_sort makes from the sorted array 0 to
+ * n-1 one position at a time, so it never has to be held in memory. It walks the halves
+ * visited by direct_unmerge_sort, starting at any position after an O(log n) descent, and
+ * then takes O(1) amortized time per item.
+ * */
+class unmerge_stream {
+public:
+	/* Starts the stream at position first of n items. */
+	unmerge_stream(size_t n, size_t first);
+
+	/* Returns the item at the current position and moves to the next one. */
+	size_t next();
+
+private:
+	/* a half of n items whose items are index + k*bit */
+	struct half {
+		size_t n;
+		size_t index;
+		size_t bit;
+	};
+	half stack_[2 * 8 * sizeof(size_t)];
+	size_t n_stacked_;
+};
+
+/* Output format of generate_unmerged.
+ *
+ * TEXT writes one decimal item per line; BINARY writes each item as a 64-bit unsigned
+ * integer in the byte order of the machine.
+ * */
+enum output_format { FORMAT_TEXT, FORMAT_BINARY };
+
+/* Writes a whole buffer to a file descriptor.
+ *
+ * This function calls write until all of data is written, retrying when it is interrupted.
+ *
+ * @param fd - the file descriptor
+ * @param data - the bytes to write
+ * @param size - the number of bytes to write
+ * @param filename - the name of the file, used in error messages
+ *
+ * @throws std::runtime_error - thrown if there is an i/o error
+ * */
+void write_all(int fd, const char *data, size_t size, const std::string &filename);
+
+/* Number of positions generate_unmerged formats at a time. */
+const size_t GENERATE_CHUNK_SIZE = 1 << 16;
+
+/* Streams a worst-case input.
+ *
+ * This function writes the items at positions [first,last) of the worst-case input of n items
+ * that unmerge_sort makes from 0 to n-1, straight to fd in format. The positions are cut into
+ * chunks of GENERATE_CHUNK_SIZE that n_threads threads take in turn, each formatting its chunk
+ * with an unmerge_stream into its own buffer and writing it with one write call once the
+ * chunk before it is written, so the output comes out in order even on a pipe. Splitting
+ * [0,n) into shards and concatenating their outputs gives the whole input.
+ *
+ * @param fd - the file descriptor to write to
+ * @param filename - the name of the output, used in error messages
+ * @param n - the number of items of the whole input
+ * @param first - the first position to write
+ * @param last - the position after the last one to write
+ * @param format - the output format
+ * @param n_threads - the number of threads to use
+ *
+ * @throws std::runtime_error - thrown if there is an i/o error
+ * */
+void generate_unmerged(int fd, const std::string &filename, size_t n, size_t first, size_t last,
+	output_format format, unsigned n_threads);
+
+/* Unmerge sort engine.
+ *
+ * CLASSIC runs unmerge_sort, which allocates and copies both halves at every level.
+ * DIRECT runs direct_unmerge_sort, which fills the array in one pass. Both produce the
+ * same permutation.
+ * */
+enum unmerge_engine { UNMERGE_CLASSIC, UNMERGE_DIRECT };
+
+/* Parses the name of an unmerge sort engine.
+ *
+ * This function converts the name given to the --unmerge option ("classic" or "direct")
+ * to the matching unmerge_engine.
+ *
+ * @param name - the name of the engine
+ *
+ * @return the engine named name
+ *
+ * @throws std::invalid_argument - thrown if name is not the name of an engine
+ * */
+unmerge_engine parse_unmerge_engine(const std::string &name);
+
 /* Merge Sort
  *
  * This function sorts a std::vector of integers using merge sort. The sorting
@@ -99,6 +244,560 @@ void merge_sort_helper(std::vector<int> &items, size_t low, size_t high, size_t
  * */
 void merge_helper(std::vector<int> &items, size_t low1, size_t high1, size_t low2, size_t high2, size_t &count);
 
+/* Comparison counter policies.
+ *
+ * The templated merge_sort counts its key comparisons with one of these. comparison_counter
+ * adds them up in count, while no_comparison_counter is empty and its add does nothing, so
+ * the counting compiles to nothing when it is used.
+ * */
+struct comparison_counter {
+	size_t count = 0;
+	void add(size_t n) { count += n; }
+};
+
+struct no_comparison_counter {
+	void add(size_t) {}
+};
+
+/* Identity projection.
+ *
+ * The default projection of the templated merge_sort; it returns the item itself.
+ * */
+struct identity_projection {
+	template <typename T>
+	T && operator()(T &&item) const { return std::forward<T>(item); }
+};
+
+/* Merge Sort
+ *
+ * This function sorts the range [first,last) using merge sort, comparing the projections
+ * proj(item) of the items with comp. Equal items keep their order. It splits and merges the
+ * same way as merge_sort on a std::vector of integers, so with a comparison_counter it counts
+ * exactly the comparisons that function returns. A single buffer of last-first items is
+ * allocated, which requires the items to be default constructible, and the items are only
+ * ever moved between the range and the buffer, never copied. When the items are trivially
+ * copyable and stored contiguously (a pointer or std::vector iterator), the merges select
+ * the next item without a branch and copy the rest of a run with memcpy.
+ *
+ * @param first - the beginning of the range to sort
+ * @param last - the ending of the range to sort
+ * @param comp - the strict weak ordering of the projections
+ * @param proj - the projection of the items compared
+ *
+ * @return the comparison counter, of type Counter
+ * */
+template <typename Counter = no_comparison_counter, typename RandomIt, typename Compare = std::less<>,
+	typename Proj = identity_projection>
+Counter merge_sort(RandomIt first, RandomIt last, Compare comp = Compare(), Proj proj = Proj());
+
+/* Templated merge sort helper function.
+ *
+ * This function sorts [first,last) and leaves the result in the range itself, or in the
+ * same positions of buffer if into_buffer is set. Both halves are sorted into the other
+ * place first, so every level moves each item exactly once.
+ *
+ * @param first - the beginning of the range to sort
+ * @param last - the ending of the range to sort
+ * @param buffer - the beginning of the buffer, as long as the range
+ * @param into_buffer - whether the result goes into the buffer
+ * @param comp - the strict weak ordering of the projections
+ * @param proj - the projection of the items compared
+ * @param counter - the comparison counter
+ * */
+template <typename RandomIt, typename BufferIt, typename Compare, typename Proj, typename Counter>
+void move_merge_sort_helper(RandomIt first, RandomIt last, BufferIt buffer, bool into_buffer, Compare &comp,
+	Proj &proj, Counter &counter);
+
+/* Merges sorted runs by moving their items.
+ *
+ * This function merges [first1,last1) and [first2,last2) into the range starting at out,
+ * taking ties from the first run. The items are moved; if both runs are pointers to the same
+ * trivially copyable type as out, the merge is branchless and the rest of the run left is
+ * copied with memcpy.
+ *
+ * @param first1 - the beginning of the first sorted run
+ * @param last1 - the ending of the first sorted run
+ * @param first2 - the beginning of the second sorted run
+ * @param last2 - the ending of the second sorted run
+ * @param out - the beginning of the output
+ * @param comp - the strict weak ordering of the projections
+ * @param proj - the projection of the items compared
+ * @param counter - the comparison counter
+ * */
+template <typename InputIt, typename OutputIt, typename Compare, typename Proj, typename Counter>
+void move_merge(InputIt first1, InputIt last1, InputIt first2, InputIt last2, OutputIt out, Compare &comp,
+	Proj &proj, Counter &counter);
+
+/* Unmerge Sort
+ *
+ * This function rearranges the sorted range [first,last) into the worst-case input for
+ * merge sort produced by unmerge_sort, with the single pass of direct_unmerge_sort. The
+ * range is moved into one buffer and the items moved back in their new order. No item is
+ * compared, so the range must already be sorted by the comparator merge_sort will use.
+ *
+ * @param first - the beginning of the sorted range
+ * @param last - the ending of the sorted range
+ * */
+template <typename RandomIt>
+void unmerge_sort(RandomIt first, RandomIt last);
+
+/* Merge sort engine.
+ *
+ * CLASSIC runs merge_sort, which copies both subarrays into new vectors on every merge.
+ * BUFFERED runs buffered_merge_sort, which allocates a single buffer up front, PARALLEL
+ * runs parallel_merge_sort, which does the same on several threads, GENERIC runs the
+ * templated merge_sort and KERNEL runs kernel_merge_sort with the selected merge_kernel. All
+ * of them report the same count.
+ * */
+enum merge_engine { MERGE_CLASSIC, MERGE_BUFFERED, MERGE_PARALLEL, MERGE_GENERIC, MERGE_KERNEL };
+
+/* Parses the name of a merge sort engine.
+ *
+ * This function converts the name given to the --engine option ("classic", "buffered",
+ * "parallel", "generic" or "kernel") to the matching merge_engine.
+ *
+ * @param name - the name of the engine
+ *
+ * @return the engine named name
+ *
+ * @throws std::invalid_argument - thrown if name is not the name of an engine
+ * */
+merge_engine parse_merge_engine(const std::string &name);
+
+/* Buffered merge sort.
+ *
+ * This function sorts a std::vector of integers using merge sort without allocating
+ * anything but one buffer the size of items. The buffer starts as a copy of items and the
+ * two vectors swap the roles of source and destination at every level of the recursion, so
+ * the runs merged at one level are read from where the level below wrote them and no
+ * subarray is ever copied. The subarrays are split and merged the same way as in merge_sort,
+ * so the number of comparisons returned is exactly the one merge_sort returns.
+ *
+ * @param items - the vector to sort
+ *
+ * @return the number of key comparisons made by the algorithm.
+ * */
+size_t buffered_merge_sort(std::vector<int> &items);
+
+/* Buffered merge sort helper function.
+ *
+ * This function sorts the elements of src between [low,high) into the same range of dst
+ * and is called by buffered_merge_sort. Both ranges must hold the same elements when it is
+ * called; src is used as scratch space and is left in an unspecified order. The number of
+ * comparisons made is added to the count variable.
+ *
+ * @param src - the vector the elements are read from
+ * @param dst - the vector the sorted elements are stored in
+ * @param low - the beginning of the list to sort (inclusive)
+ * @param high - the ending of the list to sort (exclusive)
+ * @param count - a reference to a counter for the number of key comparisons made
+ * */
+void buffered_merge_sort_helper(std::vector<int> &src, std::vector<int> &dst, size_t low, size_t high, size_t &count);
+
+/* Merge sorted subarrays into another vector.
+ *
+ * This function is merge_helper reading the sorted subarrays [low,mid) and [mid,high) from
+ * src and storing the result in [low,high) of dst instead of copying the subarrays first. The
+ * number of comparisons made by this function is added to the count parameter.
+ *
+ * @param src - the vector containing the sorted subarrays
+ * @param dst - the vector the merged subarrays are stored in
+ * @param low - the beginning of the first sorted subarray (inclusive)
+ * @param mid - the ending of the first and beginning of the second sorted subarray
+ * @param high - the ending of the second sorted subarray (exclusive)
+ * @param count - a reference to a counter for the number of key comparisons made
+ * */
+void buffered_merge_helper(const std::vector<int> &src, std::vector<int> &dst, size_t low, size_t mid, size_t high,
+	size_t &count);
+
+/* Smallest subarray parallel_merge_sort splits among threads.
+ *
+ * Below this many items a subarray is sorted by buffered_merge_sort_helper on the thread
+ * that reached it, since starting a thread costs more than sorting it.
+ * */
+const size_t PARALLEL_GRAIN_SIZE = 1 << 14;
+
+/* Parallel merge sort.
+ *
+ * This function is buffered_merge_sort on up to n_threads threads. The two halves of a
+ * subarray are sorted at the same time, each with half of the threads, until a subarray
+ * has one thread or fewer than PARALLEL_GRAIN_SIZE items left. The merges above that,
+ * which would otherwise leave all but one thread idle, are split by
+ * parallel_merge_helper. Each task counts its comparisons on its own and the counts are
+ * added up when it is joined, so the count returned is exactly the one merge_sort returns.
+ *
+ * @param items - the vector to sort
+ * @param n_threads - the number of threads to use
+ *
+ * @return the number of key comparisons made by the algorithm.
+ * */
+size_t parallel_merge_sort(std::vector<int> &items, unsigned n_threads);
+
+/* Parallel merge sort helper function.
+ *
+ * This function is buffered_merge_sort_helper using n_threads threads.
+ *
+ * @param src - the vector the elements are read from
+ * @param dst - the vector the sorted elements are stored in
+ * @param low - the beginning of the list to sort (inclusive)
+ * @param high - the ending of the list to sort (exclusive)
+ * @param n_threads - the number of threads to use
+ *
+ * @return the number of key comparisons made
+ * */
+size_t parallel_merge_sort_helper(std::vector<int> &src, std::vector<int> &dst, size_t low, size_t high,
+	unsigned n_threads);
+
+/* Co-rank of a merge.
+ *
+ * This function finds how many of the first k items of the merge of the sorted subarrays
+ * [low,mid) and [mid,high) of src come from the first subarray, with a binary search over
+ * the merge path. Ties are taken from the first subarray, as buffered_merge_helper does.
+ *
+ * @param src - the vector containing the sorted subarrays
+ * @param low - the beginning of the first sorted subarray (inclusive)
+ * @param mid - the ending of the first and beginning of the second sorted subarray
+ * @param high - the ending of the second sorted subarray (exclusive)
+ * @param k - the number of items merged, at most high-low
+ *
+ * @return the number of the first k merged items taken from [low,mid)
+ * */
+size_t merge_co_rank(const std::vector<int> &src, size_t low, size_t mid, size_t high, size_t k);
+
+/* Merge sorted subarrays into another vector in parallel.
+ *
+ * This function is buffered_merge_helper on n_threads threads. The output is cut into
+ * n_threads equal pieces and merge_co_rank finds where each one starts in both subarrays,
+ * so every thread merges its piece on its own. A thread counts a comparison for each item it
+ * stores while neither whole subarray is used up, which adds up to the count of the
+ * sequential merge; the comparisons made by the binary searches are not counted.
+ *
+ * @param src - the vector containing the sorted subarrays
+ * @param dst - the vector the merged subarrays are stored in
+ * @param low - the beginning of the first sorted subarray (inclusive)
+ * @param mid - the ending of the first and beginning of the second sorted subarray
+ * @param high - the ending of the second sorted subarray (exclusive)
+ * @param n_threads - the number of threads to use
+ *
+ * @return the number of key comparisons made
+ * */
+size_t parallel_merge_helper(const std::vector<int> &src, std::vector<int> &dst, size_t low, size_t mid, size_t high,
+	unsigned n_threads);
+
+/* Merge kernel.
+ *
+ * The loop kernel_merge_sort merges with. SCALAR is the loop of merge_helper. BRANCHLESS
+ * selects the next item with a conditional move instead of the branch that the worst-case
+ * inputs of unmerge_sort mispredict about half of the time. AVX2 merges eight 32-bit or four
+ * 64-bit keys at a time with a bitonic merge network; it falls back to BRANCHLESS on other
+ * key types and on processors without AVX2.
+ * */
+enum merge_kernel { KERNEL_SCALAR, KERNEL_BRANCHLESS, KERNEL_AVX2 };
+
+/* Parses the name of a merge kernel.
+ *
+ * This function converts the name given to the --kernel option ("scalar", "branchless" or
+ * "avx2") to the matching merge_kernel.
+ *
+ * @param name - the name of the kernel
+ *
+ * @return the kernel named name
+ *
+ * @throws std::invalid_argument - thrown if name is not the name of a kernel
+ * */
+merge_kernel parse_merge_kernel(const std::string &name);
+
+/* Comparison counts of kernel_merge_sort.
+ *
+ * logical is the number of comparisons merge_sort makes on the same items, whatever kernel
+ * is used; actual is the number of comparisons the kernel and the base case really made,
+ * each compare-exchange of a merge network counting as one.
+ * */
+struct merge_counts {
+	size_t logical;
+	size_t actual;
+};
+
+/* Default largest subarray kernel_merge_sort sorts with insertion sort. */
+const size_t DEFAULT_BASE_SIZE = 16;
+
+/* Kernel merge sort.
+ *
+ * This function is buffered_merge_sort on integer keys with the merges done by kernel and the
+ * subarrays of at most base_size items sorted by insertion sort. The logical count is found
+ * without making the comparisons it stands for: merge_comparisons finds what a merge of two
+ * sorted runs would have made with a binary search, and merge_sort_comparisons what the
+ * merges skipped by the insertion sort would have made.
+ *
+ * @param items - the vector to sort
+ * @param kernel - the merge kernel to use
+ * @param base_size - the largest subarray sorted by insertion sort; 1 disables it
+ *
+ * @return the logical and actual comparison counts
+ * */
+template <typename T>
+merge_counts kernel_merge_sort(std::vector<T> &items, merge_kernel kernel, size_t base_size = DEFAULT_BASE_SIZE);
+
+/* Kernel merge sort helper function.
+ *
+ * This function sorts the n items of src into dst and is called by kernel_merge_sort. Both
+ * must hold the same items when it is called, as in buffered_merge_sort_helper.
+ *
+ * @param src - the items to sort, used as scratch space
+ * @param dst - where the sorted items are stored
+ * @param n - the number of items
+ * @param kernel - the merge kernel to use
+ * @param base_size - the largest subarray sorted by insertion sort
+ * @param counts - the comparisons made are added here
+ * */
+template <typename T>
+void kernel_merge_sort_helper(T *src, T *dst, size_t n, merge_kernel kernel, size_t base_size, merge_counts &counts);
+
+/* Logical comparisons of a merge.
+ *
+ * The loop of merge_helper makes one comparison per item stored until one run is used up.
+ * If the last item of a is at most the last of b, a runs out first and the items of b at
+ * least as large as it are left; otherwise the items of a larger than the last of b are.
+ *
+ * @param a - the first sorted run
+ * @param n1 - the number of items in a, at least 1
+ * @param b - the second sorted run
+ * @param n2 - the number of items in b, at least 1
+ *
+ * @return the number of comparisons merge_helper makes merging a and b
+ * */
+template <typename T>
+size_t merge_comparisons(const T *a, size_t n1, const T *b, size_t n2);
+
+/* Logical comparisons of a merge sort.
+ *
+ * This function finds the number of comparisons merge_sort makes on n unsorted items without
+ * sorting them. Which items end up in each run only depends on their positions, so the rule
+ * of merge_comparisons is applied to the maxima of the two halves of every subarray.
+ *
+ * @param items - the unsorted items
+ * @param n - the number of items
+ *
+ * @return the number of comparisons merge_sort makes sorting items
+ * */
+template <typename T>
+size_t merge_sort_comparisons(const T *items, size_t n);
+
+/* Insertion sort.
+ *
+ * @param items - the items to sort
+ * @param n - the number of items
+ *
+ * @return the number of comparisons made
+ * */
+template <typename T>
+size_t insertion_sort(T *items, size_t n);
+
+/* Scalar and branchless merge kernels.
+ *
+ * These functions merge the sorted runs a and b into out, taking ties from a, one item per
+ * comparison. branchless_merge advances the runs by the result of the comparison instead of
+ * branching on it.
+ *
+ * @param a - the first sorted run
+ * @param n1 - the number of items in a
+ * @param b - the second sorted run
+ * @param n2 - the number of items in b
+ * @param out - where the merged items are stored
+ *
+ * @return the number of comparisons made
+ * */
+template <typename T>
+size_t scalar_merge(const T *a, size_t n1, const T *b, size_t n2, T *out);
+template <typename T>
+size_t branchless_merge(const T *a, size_t n1, const T *b, size_t n2, T *out);
+
+/* AVX2 merge kernels.
+ *
+ * These functions merge the sorted runs a and b into out a vector at a time. The vector of
+ * largest items left from the last step and the next vector of the run with the smaller
+ * next item form a bitonic sequence that a merge network sorts; its lower half is stored.
+ * Once a run has less than a vector left, the rest is merged by branchless_merge.
+ *
+ * @param a - the first sorted run
+ * @param n1 - the number of items in a
+ * @param b - the second sorted run
+ * @param n2 - the number of items in b
+ * @param out - where the merged items are stored
+ *
+ * @return the number of comparisons made, counting each compare-exchange as one
+ * */
+size_t avx2_merge(const std::int32_t *a, size_t n1, const std::int32_t *b, size_t n2, std::int32_t *out);
+size_t avx2_merge(const std::int64_t *a, size_t n1, const std::int64_t *b, size_t n2, std::int64_t *out);
+
+/* Checks if the processor supports AVX2.
+ *
+ * @return true if the AVX2 kernels can run
+ * */
+bool cpu_has_avx2();
+
+/* Asynchronous block reader.
+ *
+ * This class reads the 64-bit keys in [offset,offset+length) of a file in blocks of
+ * block_size keys on a thread of its own, one block ahead of the consumer, so the consumer
+ * only waits for the disk when it outpaces it. Blocks are handed over by swapping vectors,
+ * so they are never copied.
+ * */
+class async_reader {
+public:
+	async_reader(int fd, const std::string &filename, std::uint64_t offset, std::uint64_t length, size_t block_size);
+	~async_reader();
+
+	/* Swaps the next block into ret_block and returns false once there are no more.
+	 *
+	 * @throws std::runtime_error - thrown if there is an i/o error */
+	bool next(std::vector<std::uint64_t> &ret_block);
+
+private:
+	void run();
+
+	int fd_;
+	std::string filename_;
+	std::uint64_t offset_, end_;
+	size_t block_size_;
+	std::vector<std::uint64_t> filled_;
+	bool has_filled_, done_, stop_;
+	std::string error_;
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	std::thread thread_;
+};
+
+/* Asynchronous block writer.
+ *
+ * This class writes blocks of 64-bit keys one after the other from offset on a thread of its
+ * own, so the producer can fill the next block while the last one is written.
+ * */
+class async_writer {
+public:
+	async_writer(int fd, const std::string &filename, std::uint64_t offset);
+	~async_writer();
+
+	/* Queues block to be written once the block before it is, and swaps an empty vector
+	 * into it.
+	 *
+	 * @throws std::runtime_error - thrown if writing an earlier block failed */
+	void write(std::vector<std::uint64_t> &block);
+
+	/* Waits for every block to be written.
+	 *
+	 * @throws std::runtime_error - thrown if there is an i/o error */
+	void finish();
+
+private:
+	void run();
+
+	int fd_;
+	std::string filename_;
+	std::uint64_t offset_;
+	std::vector<std::uint64_t> pending_;
+	bool has_pending_, stop_;
+	std::string error_;
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	std::thread thread_;
+};
+
+/* Tree of losers.
+ *
+ * This class finds the smallest of the next keys of k sorted sources with ceil(log2 k)
+ * comparisons per key. Every internal node holds the source that lost the match played
+ * there, so when the winner's next key changes only the matches on its path to the root
+ * are replayed. heads[i] is the next key of source i and live[i] is zero once it is used
+ * up; a used up source loses every match without a comparison.
+ * */
+class loser_tree {
+public:
+	loser_tree(const std::uint64_t *heads, const char *live, size_t k);
+
+	/* The source with the smallest next key; it is used up only if all of them are. */
+	size_t winner() const { return winner_; }
+
+	/* Replays the matches of the winner after its next key or liveness changed. */
+	void replay();
+
+	/* The number of key comparisons made so far. */
+	size_t comparisons() const { return count_; }
+
+private:
+	bool less(size_t a, size_t b);
+
+	const std::uint64_t *heads_;
+	const char *live_;
+	size_t k_;
+	std::vector<size_t> losers_;
+	size_t winner_;
+	size_t count_;
+};
+
+/* A sorted run of keys in a file, as a byte offset and a number of keys. */
+struct sorted_run {
+	std::uint64_t offset;
+	std::uint64_t n_keys;
+};
+
+/* Statistics of external_merge_sort. */
+struct external_sort_stats {
+	std::uint64_t n_keys;
+	size_t n_runs;
+	size_t n_passes;
+	size_t run_comparisons;
+	size_t merge_comparisons;
+};
+
+/* Keys per block of the readers and writers of the merge passes. */
+const size_t MERGE_BLOCK_SIZE = 1 << 15;
+
+/* Default memory budget of external_merge_sort in bytes. */
+const size_t DEFAULT_EXTERNAL_MEMORY = 256 << 20;
+
+/* External merge sort.
+ *
+ * This function sorts a file of 64-bit unsigned keys in the byte order of the machine, the
+ * binary format of --generate, that may be larger than memory, into outfile. The input is
+ * read in runs of about memory/48 bytes that are sorted by the templated merge_sort, while
+ * the reader fetches the next run and the writer stores the last one, and written to a
+ * temporary file. The runs are then merged with a loser_tree as many at a time as memory
+ * allows, again with a reader per run and a writer, until one pass writes outfile. An input
+ * that fits in one run is sorted straight into outfile, and merge_sort then makes all of
+ * the comparisons, so the count is exactly the in-memory one.
+ *
+ * @param infile - the file of keys to sort
+ * @param outfile - the file the sorted keys are written to
+ * @param memory - the memory budget in bytes
+ *
+ * @return the number of keys, runs and merge passes and the comparisons made
+ *
+ * @throws std::runtime_error - thrown if there is an i/o error or the size of infile is
+ *                              not a multiple of 8 bytes
+ * */
+external_sort_stats external_merge_sort(const std::string &infile, const std::string &outfile, size_t memory);
+
+/* Sorts the runs of an external merge sort.
+ *
+ * This function reads in_fd in runs of run_size keys, sorts each one with merge_sort and
+ * writes them to out_fd one after the other, recording where each run went in ret_runs.
+ *
+ * @return the number of comparisons made
+ * */
+size_t form_runs(int in_fd, const std::string &infile, std::uint64_t n_keys, size_t run_size, int out_fd,
+	const std::string &outfile, std::vector<sorted_run> &ret_runs);
+
+/* Merges sorted runs.
+ *
+ * This function merges the runs [first,last) of runs in in_fd with a loser_tree and writes
+ * the result to out_fd at out_offset.
+ *
+ * @return the number of comparisons made
+ * */
+size_t merge_runs(int in_fd, const std::string &infile, const std::vector<sorted_run> &runs, size_t first, size_t last,
+	int out_fd, const std::string &outfile, std::uint64_t out_offset);
+
 
 
 
@@ -119,6 +818,110 @@ std::ostream& operator<< (std::ostream& os, const Container<T>& container) {
 	return os;
 }
 
+template <typename InputIt, typename OutputIt, typename Compare, typename Proj, typename Counter>
+void move_merge(InputIt first1, InputIt last1, InputIt first2, InputIt last2, OutputIt out, Compare &comp,
+	Proj &proj, Counter &counter) {
+	typedef typename std::iterator_traits<InputIt>::value_type value_type;
+	if constexpr (std::is_pointer<InputIt>::value && std::is_same<InputIt, OutputIt>::value
+		&& std::is_trivially_copyable<value_type>::value) {
+		while((first1 != last1) && (first2 != last2)) {
+			/* a single comparison is made ever executeion of this loop */
+			counter.add(1);
+			bool take2 = comp(proj(*first2), proj(*first1));
+			*out++ = take2 ? *first2 : *first1;
+			first2 += take2;
+			first1 += !take2;
+		}
+		std::memcpy(out, first1, (last1 - first1) * sizeof(value_type));
+		out += last1 - first1;
+		std::memcpy(out, first2, (last2 - first2) * sizeof(value_type));
+	}
+	else {
+		while((first1 != last1) && (first2 != last2)) {
+			/* a single comparison is made ever executeion of this loop */
+			counter.add(1);
+			if(comp(proj(*first2), proj(*first1))) {
+				*out++ = std::move(*first2++);
+			}
+			else {
+				*out++ = std::move(*first1++);
+			}
+		}
+		out = std::move(first1, last1, out);
+		std::move(first2, last2, out);
+	}
+}
+
+template <typename RandomIt, typename BufferIt, typename Compare, typename Proj, typename Counter>
+void move_merge_sort_helper(RandomIt first, RandomIt last, BufferIt buffer, bool into_buffer, Compare &comp,
+	Proj &proj, Counter &counter) {
+	typename std::iterator_traits<RandomIt>::difference_type n = last - first;
+	if(n < 2) {
+		if(n == 1 && into_buffer)
+			*buffer = std::move(*first);
+		return;
+	}
+
+	/* the halves go to the other place so they can be merged into this one */
+	RandomIt mid = first + n / 2;
+	BufferIt buffer_mid = buffer + n / 2;
+	move_merge_sort_helper(first, mid, buffer, !into_buffer, comp, proj, counter);
+	move_merge_sort_helper(mid, last, buffer_mid, !into_buffer, comp, proj, counter);
+	if(into_buffer)
+		move_merge(first, mid, mid, last, buffer, comp, proj, counter);
+	else
+		move_merge(buffer, buffer_mid, buffer_mid, buffer + n, first, comp, proj, counter);
+}
+
+template <typename Counter, typename RandomIt, typename Compare, typename Proj>
+Counter merge_sort(RandomIt first, RandomIt last, Compare comp, Proj proj) {
+	typedef typename std::iterator_traits<RandomIt>::value_type value_type;
+	Counter counter;
+	if(last - first < 2)
+		return counter;
+
+	std::vector<value_type> buffer(last - first);
+	/* contiguous trivially copyable items are sorted through pointers to get the memcpy merge */
+	if constexpr (std::is_trivially_copyable<value_type>::value
+		&& (std::is_pointer<RandomIt>::value || std::is_same<RandomIt, typename std::vector<value_type>::iterator>::value)) {
+		move_merge_sort_helper(&*first, &*first + (last - first), buffer.data(), false, comp, proj, counter);
+	}
+	else {
+		move_merge_sort_helper(first, last, buffer.begin(), false, comp, proj, counter);
+	}
+	return counter;
+}
+
+template <typename RandomIt>
+void unmerge_sort(RandomIt first, RandomIt last) {
+	typedef typename std::iterator_traits<RandomIt>::value_type value_type;
+	/* a half of n items whose items come from the positions index + k*bit of the sorted range */
+	struct half {
+		size_t n;
+		size_t index;
+		size_t bit;
+	};
+	/* the left half is always taken first, so at most one right half is waiting per level */
+	half stack[2 * 8 * sizeof(size_t)];
+	size_t n_stacked = 0;
+
+	if(last - first <= 1)
+		return;
+	std::vector<value_type> sorted(std::make_move_iterator(first), std::make_move_iterator(last));
+	stack[n_stacked++] = half{sorted.size(), 0, 1};
+	while(n_stacked > 0) {
+		half h = stack[--n_stacked];
+		if(h.n == 1) {
+			*first++ = std::move(sorted[h.index]);
+		}
+		else {
+			size_t n_left = (h.n + 1) / 2;
+			stack[n_stacked++] = half{h.n - n_left, h.index | h.bit, h.bit << 1};
+			stack[n_stacked++] = half{n_left, h.index, h.bit << 1};
+		}
+	}
+}
+
 void unmerge_sort_helper(std::vector<int> &items, size_t l, size_t r){
 	/* if l < r then there is at least 2 items left so we must keep going*/
 	if(l < r){
@@ -161,6 +964,26 @@ void unmerge_sort(std::vector<int> &items) {
 	}
 }
 
+size_t unmerge_index(size_t p, size_t n) {
+	size_t index = 0;
+	for(size_t bit = 1; n > 1; bit <<= 1) {
+		size_t n_left = n / 2 + n % 2;
+		if(p < n_left) {
+			n = n_left;
+		}
+		else {
+			index |= bit;
+			p -= n_left;
+			n -= n_left;
+		}
+	}
+	return index;
+}
+
+void direct_unmerge_sort(std::vector<int> &items) {
+	unmerge_sort(items.begin(), items.end());
+}
+
 void merge_helper(std::vector<int> &items, size_t low1, size_t high1, size_t low2, size_t high2, size_t &count) {
 	/* copy the sorted subarrays into left and right */
 	std::vector<int> left(items.begin()+low1, items.begin()+high1);
@@ -203,24 +1026,1071 @@ size_t merge_sort(std::vector<int> &items) {
 	return count;
 }
 
+unmerge_engine parse_unmerge_engine(const std::string &name) {
+	if(name == "classic")
+		return UNMERGE_CLASSIC;
+	else if(name == "direct")
+		return UNMERGE_DIRECT;
+
+	std::ostringstream oss;
+	oss << "unknown unmerge engine: " << name;
+	throw std::invalid_argument(oss.str());
+}
+
+unmerge_stream::unmerge_stream(size_t n, size_t first) : n_stacked_(0) {
+	/* the halves to the right of the path down to first are still to come */
+	half h = {n, 0, 1};
+	while(h.n > 1) {
+		size_t n_left = h.n / 2 + h.n % 2;
+		if(first < n_left) {
+			stack_[n_stacked_++] = half{h.n - n_left, h.index | h.bit, h.bit << 1};
+			h = half{n_left, h.index, h.bit << 1};
+		}
+		else {
+			first -= n_left;
+			h = half{h.n - n_left, h.index | h.bit, h.bit << 1};
+		}
+	}
+	stack_[n_stacked_++] = h;
+}
+
+size_t unmerge_stream::next() {
+	half h = stack_[--n_stacked_];
+	while(h.n > 1) {
+		size_t n_left = h.n / 2 + h.n % 2;
+		stack_[n_stacked_++] = half{h.n - n_left, h.index | h.bit, h.bit << 1};
+		h = half{n_left, h.index, h.bit << 1};
+	}
+	return h.index;
+}
+
+void write_all(int fd, const char *data, size_t size, const std::string &filename) {
+	while(size > 0) {
+		ssize_t n_written = write(fd, data, size);
+		if(n_written < 0 && errno == EINTR)
+			continue;
+		if(n_written < 0) {
+			std::ostringstream oss;
+			oss << filename << ": " << std::strerror(errno);
+			throw std::runtime_error(oss.str());
+		}
+		data += n_written;
+		size -= n_written;
+	}
+}
+
+void generate_unmerged(int fd, const std::string &filename, size_t n, size_t first, size_t last,
+	output_format format, unsigned n_threads) {
+	/* rounded up without forming last - first + GENERATE_CHUNK_SIZE, which can overflow */
+	size_t n_chunks = (last - first) / GENERATE_CHUNK_SIZE + ((last - first) % GENERATE_CHUNK_SIZE != 0);
+	size_t next_write = 0;
+	bool failed = false;
+	std::exception_ptr error;
+	std::mutex mutex;
+	std::condition_variable written;
+	std::vector<std::thread> threads;
+	n_threads = std::max(1u, n_threads);
+
+	auto worker = [&](unsigned t) {
+		/* a decimal size_t takes at most 20 digits */
+		std::vector<char> buffer(GENERATE_CHUNK_SIZE * (format == FORMAT_TEXT ? 21 : sizeof(std::uint64_t)));
+		for(size_t chunk = t; chunk < n_chunks; chunk += n_threads) {
+			size_t p = first + chunk * GENERATE_CHUNK_SIZE;
+			size_t end = p + std::min(GENERATE_CHUNK_SIZE, last - p);
+			unmerge_stream stream(n, p);
+			char *pos = buffer.data();
+			if(format == FORMAT_TEXT) {
+				for(; p < end; p++) {
+					pos = std::to_chars(pos, buffer.data() + buffer.size(), stream.next()).ptr;
+					*pos++ = '\n';
+				}
+			}
+			else {
+				for(; p < end; p++) {
+					std::uint64_t item = stream.next();
+					std::memcpy(pos, &item, sizeof(item));
+					pos += sizeof(item);
+				}
+			}
+
+			/* the chunks are written in order */
+			std::unique_lock<std::mutex> lock(mutex);
+			written.wait(lock, [&]() { return next_write == chunk || failed; });
+			if(failed)
+				return;
+			try {
+				write_all(fd, buffer.data(), pos - buffer.data(), filename);
+			}
+			catch (...) {
+				failed = true;
+				error = std::current_exception();
+			}
+			next_write++;
+			written.notify_all();
+		}
+	};
+
+	for(unsigned t = 1; t < n_threads; t++) {
+		threads.push_back(std::thread(worker, t));
+	}
+	worker(0);
+	for(std::thread &thread : threads) {
+		thread.join();
+	}
+	if(error)
+		std::rethrow_exception(error);
+}
+
+merge_engine parse_merge_engine(const std::string &name) {
+	if(name == "classic")
+		return MERGE_CLASSIC;
+	else if(name == "buffered")
+		return MERGE_BUFFERED;
+	else if(name == "parallel")
+		return MERGE_PARALLEL;
+	else if(name == "generic")
+		return MERGE_GENERIC;
+	else if(name == "kernel")
+		return MERGE_KERNEL;
+
+	std::ostringstream oss;
+	oss << "unknown engine: " << name;
+	throw std::invalid_argument(oss.str());
+}
+
+void buffered_merge_helper(const std::vector<int> &src, std::vector<int> &dst, size_t low, size_t mid, size_t high,
+	size_t &count) {
+	size_t ii=low, jj=mid, kk=low;
+	while((ii < mid) && (jj < high)) {
+		/* a single comparison is made ever executeion of this loop */
+		count++;
+		if(src[ii] <= src[jj]) {
+			dst[kk++] = src[ii++];
+		}
+		else {
+			dst[kk++] = src[jj++];
+		}
+	}
+	while(ii < mid) {
+		dst[kk++] = src[ii++];
+	}
+	while(jj < high) {
+		dst[kk++] = src[jj++];
+	}
+}
+
+void buffered_merge_sort_helper(std::vector<int> &src, std::vector<int> &dst, size_t low, size_t high, size_t &count) {
+	/* nothing to sort unless there is more than 1 item, and then src and dst already agree */
+	if(high-low > 1) {
+		size_t mid = (high-low)/2 + low;
+		/* sort both halves into src so they can be merged into dst */
+		buffered_merge_sort_helper(dst, src, low, mid, count);
+		buffered_merge_sort_helper(dst, src, mid, high, count);
+		buffered_merge_helper(src, dst, low, mid, high, count);
+	}
+}
+
+size_t buffered_merge_sort(std::vector<int> &items) {
+	size_t count = 0;
+	std::vector<int> buffer(items);
+	buffered_merge_sort_helper(buffer, items, 0, items.size(), count);
+	return count;
+}
+
+size_t merge_co_rank(const std::vector<int> &src, size_t low, size_t mid, size_t high, size_t k) {
+	/* i items from the first subarray and k-i from the second */
+	size_t lo = (k > high - mid) ? k - (high - mid) : 0;
+	size_t hi = std::min(k, mid - low);
+	while(lo < hi) {
+		size_t i = (lo + hi) / 2;
+		size_t j = k - i;
+		/* the (i+1)-th item of the first subarray is taken before the j-th of the second */
+		if(src[low + i] <= src[mid + j - 1])
+			lo = i + 1;
+		else
+			hi = i;
+	}
+	return lo;
+}
+
+size_t parallel_merge_helper(const std::vector<int> &src, std::vector<int> &dst, size_t low, size_t mid, size_t high,
+	unsigned n_threads) {
+	std::vector<size_t> counts(n_threads, 0);
+	std::vector<std::thread> threads;
+
+	auto merge_piece = [&](unsigned t) {
+		size_t k0 = (high - low) * t / n_threads, k1 = (high - low) * (t + 1) / n_threads;
+		size_t i0 = merge_co_rank(src, low, mid, high, k0), i1 = merge_co_rank(src, low, mid, high, k1);
+		size_t ii = low + i0, jj = mid + (k0 - i0), kk = low + k0;
+		size_t high1 = low + i1, high2 = mid + (k1 - i1);
+		size_t count = 0;
+		while((ii < high1) && (jj < high2)) {
+			count++;
+			if(src[ii] <= src[jj]) {
+				dst[kk++] = src[ii++];
+			}
+			else {
+				dst[kk++] = src[jj++];
+			}
+		}
+		/* the sequential merge still compares while the other subarray has items left */
+		count += (high2 < high) ? high1 - ii : 0;
+		count += (high1 < mid) ? high2 - jj : 0;
+		while(ii < high1) {
+			dst[kk++] = src[ii++];
+		}
+		while(jj < high2) {
+			dst[kk++] = src[jj++];
+		}
+		counts[t] = count;
+	};
+
+	for(unsigned t = 1; t < n_threads; t++) {
+		threads.push_back(std::thread(merge_piece, t));
+	}
+	merge_piece(0);
+	for(std::thread &thread : threads) {
+		thread.join();
+	}
+
+	size_t count = 0;
+	for(size_t c : counts) {
+		count += c;
+	}
+	return count;
+}
+
+size_t parallel_merge_sort_helper(std::vector<int> &src, std::vector<int> &dst, size_t low, size_t high,
+	unsigned n_threads) {
+	size_t count = 0;
+	if(n_threads <= 1 || high - low < PARALLEL_GRAIN_SIZE) {
+		buffered_merge_sort_helper(src, dst, low, high, count);
+		return count;
+	}
+
+	/* the first half is sorted by a new task with half of the threads */
+	size_t mid = (high-low)/2 + low;
+	unsigned n_left = n_threads / 2;
+	size_t left_count = 0;
+	std::thread left([&]() {
+		left_count = parallel_merge_sort_helper(dst, src, low, mid, n_left);
+	});
+	count = parallel_merge_sort_helper(dst, src, mid, high, n_threads - n_left);
+	left.join();
+	return left_count + count + parallel_merge_helper(src, dst, low, mid, high, n_threads);
+}
+
+size_t parallel_merge_sort(std::vector<int> &items, unsigned n_threads) {
+	std::vector<int> buffer(items);
+	return parallel_merge_sort_helper(buffer, items, 0, items.size(), std::max(1u, n_threads));
+}
+
+merge_kernel parse_merge_kernel(const std::string &name) {
+	if(name == "scalar")
+		return KERNEL_SCALAR;
+	else if(name == "branchless")
+		return KERNEL_BRANCHLESS;
+	else if(name == "avx2")
+		return KERNEL_AVX2;
+
+	std::ostringstream oss;
+	oss << "unknown kernel: " << name;
+	throw std::invalid_argument(oss.str());
+}
+
+template <typename T>
+size_t merge_comparisons(const T *a, size_t n1, const T *b, size_t n2) {
+	if(a[n1 - 1] <= b[n2 - 1])
+		return n1 + (std::lower_bound(b, b + n2, a[n1 - 1]) - b);
+	return n2 + (std::upper_bound(a, a + n1, b[n2 - 1]) - a);
+}
+
+template <typename T>
+size_t merge_sort_comparisons(const T *items, size_t n) {
+	if(n < 2)
+		return 0;
+	size_t m = n / 2;
+	size_t count = merge_sort_comparisons(items, m) + merge_sort_comparisons(items + m, n - m);
+	T max1 = *std::max_element(items, items + m), max2 = *std::max_element(items + m, items + n);
+	size_t left = 0;
+	if(max1 <= max2) {
+		for(size_t i = m; i < n; i++) {
+			left += (items[i] >= max1);
+		}
+	}
+	else {
+		for(size_t i = 0; i < m; i++) {
+			left += (items[i] > max2);
+		}
+	}
+	return count + n - left;
+}
+
+template <typename T>
+size_t insertion_sort(T *items, size_t n) {
+	size_t count = 0;
+	for(size_t i = 1; i < n; i++) {
+		T item = items[i];
+		size_t j = i;
+		while(j > 0) {
+			count++;
+			if(!(item < items[j - 1]))
+				break;
+			items[j] = items[j - 1];
+			j--;
+		}
+		items[j] = item;
+	}
+	return count;
+}
+
+template <typename T>
+size_t scalar_merge(const T *a, size_t n1, const T *b, size_t n2, T *out) {
+	size_t ii = 0, jj = 0, count = 0;
+	while((ii < n1) && (jj < n2)) {
+		count++;
+		if(a[ii] <= b[jj]) {
+			*out++ = a[ii++];
+		}
+		else {
+			*out++ = b[jj++];
+		}
+	}
+	std::memcpy(out, a + ii, (n1 - ii) * sizeof(T));
+	std::memcpy(out + (n1 - ii), b + jj, (n2 - jj) * sizeof(T));
+	return count;
+}
+
+template <typename T>
+size_t branchless_merge(const T *a, size_t n1, const T *b, size_t n2, T *out) {
+	const T *a_end = a + n1, *b_end = b + n2;
+	size_t count = 0;
+	while((a != a_end) && (b != b_end)) {
+		bool take_a = (*a <= *b);
+		*out++ = take_a ? *a : *b;
+		a += take_a;
+		b += !take_a;
+		count++;
+	}
+	std::memcpy(out, a, (a_end - a) * sizeof(T));
+	std::memcpy(out + (a_end - a), b, (b_end - b) * sizeof(T));
+	return count;
+}
+
+/* Merges the largest items left from the vector kernel, lo, with the rest of both runs. */
+template <typename T>
+size_t finish_vector_merge(const T *lo, size_t n_lo, const T *a, size_t n1, const T *b, size_t n2, T *out) {
+	/* one run has less than a vector left, so it is merged with lo on the stack first */
+	T merged[64 / sizeof(T)];
+	if(n1 > n2) {
+		std::swap(a, b);
+		std::swap(n1, n2);
+	}
+	size_t count = branchless_merge(lo, n_lo, a, n1, merged);
+	return count + branchless_merge(merged, n_lo + n1, b, n2, out);
+}
+
+#ifdef UNMERGE_X86_SIMD
+/* Sorts two sorted vectors of eight 32-bit keys into lo and hi with 32 compare-exchanges. */
+__attribute__((target("avx2")))
+inline void bitonic_merge_avx2(__m256i &lo, __m256i &hi) {
+	__m256i rev = _mm256_permutevar8x32_epi32(hi, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+	__m256i v[2] = {_mm256_min_epi32(lo, rev), _mm256_max_epi32(lo, rev)};
+	for(__m256i &x : v) {
+		__m256i t = _mm256_permute2x128_si256(x, x, 0x01);
+		x = _mm256_blend_epi32(_mm256_min_epi32(x, t), _mm256_max_epi32(x, t), 0xF0);
+		t = _mm256_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2));
+		x = _mm256_blend_epi32(_mm256_min_epi32(x, t), _mm256_max_epi32(x, t), 0xCC);
+		t = _mm256_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1));
+		x = _mm256_blend_epi32(_mm256_min_epi32(x, t), _mm256_max_epi32(x, t), 0xAA);
+	}
+	lo = v[0];
+	hi = v[1];
+}
+
+/* The minimum and maximum of 64-bit keys, which AVX2 has no instruction for. */
+__attribute__((target("avx2")))
+inline void min_max_epi64(__m256i x, __m256i y, __m256i &ret_min, __m256i &ret_max) {
+	__m256i gt = _mm256_cmpgt_epi64(x, y);
+	ret_min = _mm256_blendv_epi8(x, y, gt);
+	ret_max = _mm256_blendv_epi8(y, x, gt);
+}
+
+/* Sorts two sorted vectors of four 64-bit keys into lo and hi with 12 compare-exchanges. */
+__attribute__((target("avx2")))
+inline void bitonic_merge_avx2_epi64(__m256i &lo, __m256i &hi) {
+	__m256i rev = _mm256_permute4x64_epi64(hi, _MM_SHUFFLE(0, 1, 2, 3));
+	__m256i v[2], mn, mx;
+	min_max_epi64(lo, rev, v[0], v[1]);
+	for(__m256i &x : v) {
+		min_max_epi64(x, _mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 0, 3, 2)), mn, mx);
+		x = _mm256_blend_epi32(mn, mx, 0xF0);
+		min_max_epi64(x, _mm256_permute4x64_epi64(x, _MM_SHUFFLE(2, 3, 0, 1)), mn, mx);
+		x = _mm256_blend_epi32(mn, mx, 0xCC);
+	}
+	lo = v[0];
+	hi = v[1];
+}
+
+__attribute__((target("avx2")))
+size_t avx2_merge(const std::int32_t *a, size_t n1, const std::int32_t *b, size_t n2, std::int32_t *out) {
+	const size_t width = 8;
+	if(n1 < width || n2 < width)
+		return branchless_merge(a, n1, b, n2, out);
+
+	__m256i lo = _mm256_loadu_si256((const __m256i *)a), hi = _mm256_loadu_si256((const __m256i *)b);
+	size_t ii = width, jj = width, count = 0;
+	for(;;) {
+		bitonic_merge_avx2(lo, hi);
+		count += 32;
+		_mm256_storeu_si256((__m256i *)out, lo);
+		out += width;
+		if(ii + width > n1 || jj + width > n2)
+			break;
+		/* the next vector comes from the run whose next item is smaller */
+		count++;
+		if(a[ii] <= b[jj]) {
+			lo = _mm256_loadu_si256((const __m256i *)(a + ii));
+			ii += width;
+		}
+		else {
+			lo = _mm256_loadu_si256((const __m256i *)(b + jj));
+			jj += width;
+		}
+	}
+	std::int32_t rest[width];
+	_mm256_storeu_si256((__m256i *)rest, hi);
+	return count + finish_vector_merge(rest, width, a + ii, n1 - ii, b + jj, n2 - jj, out);
+}
+
+__attribute__((target("avx2")))
+size_t avx2_merge(const std::int64_t *a, size_t n1, const std::int64_t *b, size_t n2, std::int64_t *out) {
+	const size_t width = 4;
+	if(n1 < width || n2 < width)
+		return branchless_merge(a, n1, b, n2, out);
+
+	__m256i lo = _mm256_loadu_si256((const __m256i *)a), hi = _mm256_loadu_si256((const __m256i *)b);
+	size_t ii = width, jj = width, count = 0;
+	for(;;) {
+		bitonic_merge_avx2_epi64(lo, hi);
+		count += 12;
+		_mm256_storeu_si256((__m256i *)out, lo);
+		out += width;
+		if(ii + width > n1 || jj + width > n2)
+			break;
+		/* the next vector comes from the run whose next item is smaller */
+		count++;
+		if(a[ii] <= b[jj]) {
+			lo = _mm256_loadu_si256((const __m256i *)(a + ii));
+			ii += width;
+		}
+		else {
+			lo = _mm256_loadu_si256((const __m256i *)(b + jj));
+			jj += width;
+		}
+	}
+	std::int64_t rest[width];
+	_mm256_storeu_si256((__m256i *)rest, hi);
+	return count + finish_vector_merge(rest, width, a + ii, n1 - ii, b + jj, n2 - jj, out);
+}
+
+bool cpu_has_avx2() {
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+}
+#else
+size_t avx2_merge(const std::int32_t *a, size_t n1, const std::int32_t *b, size_t n2, std::int32_t *out) {
+	return branchless_merge(a, n1, b, n2, out);
+}
+
+size_t avx2_merge(const std::int64_t *a, size_t n1, const std::int64_t *b, size_t n2, std::int64_t *out) {
+	return branchless_merge(a, n1, b, n2, out);
+}
+
+bool cpu_has_avx2() {
+	return false;
+}
+#endif
+
+template <typename T>
+void kernel_merge_sort_helper(T *src, T *dst, size_t n, merge_kernel kernel, size_t base_size, merge_counts &counts) {
+	if(n < 2)
+		return;
+	/* src and dst hold the same items, so a small subarray is simply sorted in place */
+	if(n <= base_size) {
+		counts.logical += merge_sort_comparisons(dst, n);
+		counts.actual += insertion_sort(dst, n);
+		return;
+	}
+
+	size_t m = n / 2;
+	kernel_merge_sort_helper(dst, src, m, kernel, base_size, counts);
+	kernel_merge_sort_helper(dst + m, src + m, n - m, kernel, base_size, counts);
+	if(kernel == KERNEL_SCALAR || kernel == KERNEL_BRANCHLESS) {
+		size_t count = (kernel == KERNEL_SCALAR) ? scalar_merge(src, m, src + m, n - m, dst)
+			: branchless_merge(src, m, src + m, n - m, dst);
+		counts.logical += count;
+		counts.actual += count;
+	}
+	else {
+		counts.logical += merge_comparisons(src, m, src + m, n - m);
+		if constexpr (std::is_same<T, std::int32_t>::value || std::is_same<T, std::int64_t>::value)
+			counts.actual += avx2_merge(src, m, src + m, n - m, dst);
+		else
+			counts.actual += branchless_merge(src, m, src + m, n - m, dst);
+	}
+}
+
+template <typename T>
+merge_counts kernel_merge_sort(std::vector<T> &items, merge_kernel kernel, size_t base_size) {
+	merge_counts counts = {0, 0};
+	if(kernel == KERNEL_AVX2 && !cpu_has_avx2())
+		kernel = KERNEL_BRANCHLESS;
+	if(items.size() < 2)
+		return counts;
+	std::vector<T> buffer(items);
+	kernel_merge_sort_helper(buffer.data(), items.data(), items.size(), kernel, std::max<size_t>(1, base_size), counts);
+	return counts;
+}
+
+async_reader::async_reader(int fd, const std::string &filename, std::uint64_t offset, std::uint64_t length,
+	size_t block_size) : fd_(fd), filename_(filename), offset_(offset), end_(offset + length),
+	block_size_(std::max<size_t>(1, block_size)), has_filled_(false), done_(false), stop_(false) {
+	thread_ = std::thread(&async_reader::run, this);
+}
+
+async_reader::~async_reader() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	cv_.notify_all();
+	thread_.join();
+}
+
+void async_reader::run() {
+	std::vector<std::uint64_t> block;
+	for(;;) {
+		size_t n = (size_t)std::min<std::uint64_t>(block_size_, (end_ - offset_) / sizeof(std::uint64_t));
+		std::string error;
+		block.resize(n);
+		for(size_t done = 0; done < n * sizeof(std::uint64_t); ) {
+			ssize_t n_read = pread(fd_, (char *)block.data() + done, n * sizeof(std::uint64_t) - done, offset_ + done);
+			if(n_read < 0 && errno == EINTR)
+				continue;
+			if(n_read <= 0) {
+				error = filename_ + ": " + (n_read < 0 ? std::strerror(errno) : "unexpected end of file");
+				break;
+			}
+			done += n_read;
+		}
+		offset_ += n * sizeof(std::uint64_t);
+
+		std::unique_lock<std::mutex> lock(mutex_);
+		if(n == 0 || !error.empty()) {
+			error_ = error;
+			done_ = true;
+			cv_.notify_all();
+			return;
+		}
+		cv_.wait(lock, [&]() { return !has_filled_ || stop_; });
+		if(stop_)
+			return;
+		/* block gets back the buffer the consumer swapped in last time */
+		filled_.swap(block);
+		has_filled_ = true;
+		cv_.notify_all();
+	}
+}
+
+bool async_reader::next(std::vector<std::uint64_t> &ret_block) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	cv_.wait(lock, [&]() { return has_filled_ || done_; });
+	if(!has_filled_) {
+		if(!error_.empty())
+			throw std::runtime_error(error_);
+		return false;
+	}
+	ret_block.swap(filled_);
+	has_filled_ = false;
+	cv_.notify_all();
+	return true;
+}
+
+async_writer::async_writer(int fd, const std::string &filename, std::uint64_t offset) : fd_(fd),
+	filename_(filename), offset_(offset), has_pending_(false), stop_(false) {
+	thread_ = std::thread(&async_writer::run, this);
+}
+
+async_writer::~async_writer() {
+	if(thread_.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+		cv_.notify_all();
+		thread_.join();
+	}
+}
+
+void async_writer::run() {
+	std::vector<std::uint64_t> block;
+	for(;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cv_.wait(lock, [&]() { return has_pending_ || stop_; });
+			if(!has_pending_)
+				return;
+			block.swap(pending_);
+			has_pending_ = false;
+			cv_.notify_all();
+			/* the blocks queued after an error are dropped */
+			if(!error_.empty())
+				continue;
+		}
+
+		std::string error;
+		size_t size = block.size() * sizeof(std::uint64_t);
+		for(size_t done = 0; done < size; ) {
+			ssize_t n_written = pwrite(fd_, (const char *)block.data() + done, size - done, offset_ + done);
+			if(n_written < 0 && errno == EINTR)
+				continue;
+			if(n_written < 0) {
+				error = filename_ + ": " + std::strerror(errno);
+				break;
+			}
+			done += n_written;
+		}
+		offset_ += size;
+		if(!error.empty()) {
+			std::lock_guard<std::mutex> lock(mutex_);
+			error_ = error;
+		}
+	}
+}
+
+void async_writer::write(std::vector<std::uint64_t> &block) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	cv_.wait(lock, [&]() { return !has_pending_; });
+	if(!error_.empty())
+		throw std::runtime_error(error_);
+	pending_.swap(block);
+	has_pending_ = true;
+	block.clear();
+	cv_.notify_all();
+}
+
+void async_writer::finish() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	cv_.notify_all();
+	thread_.join();
+	if(!error_.empty())
+		throw std::runtime_error(error_);
+}
+
+loser_tree::loser_tree(const std::uint64_t *heads, const char *live, size_t k) : heads_(heads), live_(live),
+	k_(k), losers_(k), winner_(0), count_(0) {
+	/* node n has children 2n and 2n+1 and source i is leaf k+i */
+	std::vector<size_t> winners(2 * k);
+	for(size_t i = 0; i < k; i++) {
+		winners[k + i] = i;
+	}
+	for(size_t node = k - 1; node >= 1; node--) {
+		size_t a = winners[2 * node], b = winners[2 * node + 1];
+		bool a_wins = less(a, b);
+		winners[node] = a_wins ? a : b;
+		losers_[node] = a_wins ? b : a;
+	}
+	winner_ = (k > 1) ? winners[1] : 0;
+}
+
+bool loser_tree::less(size_t a, size_t b) {
+	if(!live_[a] || !live_[b])
+		return live_[a] || (!live_[b] && a < b);
+	count_++;
+	return heads_[a] < heads_[b] || (heads_[a] == heads_[b] && a < b);
+}
+
+void loser_tree::replay() {
+	size_t winner = winner_;
+	for(size_t node = (k_ + winner_) / 2; node >= 1; node /= 2) {
+		if(less(losers_[node], winner))
+			std::swap(losers_[node], winner);
+	}
+	winner_ = winner;
+}
+
+size_t form_runs(int in_fd, const std::string &infile, std::uint64_t n_keys, size_t run_size, int out_fd,
+	const std::string &outfile, std::vector<sorted_run> &ret_runs) {
+	async_reader reader(in_fd, infile, 0, n_keys * sizeof(std::uint64_t), run_size);
+	async_writer writer(out_fd, outfile, 0);
+	std::vector<std::uint64_t> run;
+	std::uint64_t offset = 0;
+	size_t count = 0;
+
+	ret_runs.clear();
+	while(reader.next(run)) {
+		count += merge_sort<comparison_counter>(run.begin(), run.end()).count;
+		ret_runs.push_back(sorted_run{offset, run.size()});
+		offset += run.size() * sizeof(std::uint64_t);
+		writer.write(run);
+	}
+	writer.finish();
+	return count;
+}
+
+size_t merge_runs(int in_fd, const std::string &infile, const std::vector<sorted_run> &runs, size_t first, size_t last,
+	int out_fd, const std::string &outfile, std::uint64_t out_offset) {
+	size_t k = last - first;
+	std::vector<std::unique_ptr<async_reader>> readers(k);
+	std::vector<std::vector<std::uint64_t>> blocks(k);
+	std::vector<size_t> positions(k, 0);
+	std::vector<std::uint64_t> heads(k, 0);
+	std::vector<char> live(k, 0);
+	std::vector<std::uint64_t> out;
+	async_writer writer(out_fd, outfile, out_offset);
+
+	for(size_t i = 0; i < k; i++) {
+		const sorted_run &run = runs[first + i];
+		readers[i].reset(new async_reader(in_fd, infile, run.offset, run.n_keys * sizeof(std::uint64_t), MERGE_BLOCK_SIZE));
+		live[i] = readers[i]->next(blocks[i]);
+		heads[i] = live[i] ? blocks[i][0] : 0;
+	}
+
+	loser_tree tree(heads.data(), live.data(), k);
+	out.reserve(MERGE_BLOCK_SIZE);
+	for(size_t w = tree.winner(); live[w]; w = tree.winner()) {
+		out.push_back(heads[w]);
+		if(out.size() == MERGE_BLOCK_SIZE) {
+			writer.write(out);
+			out.reserve(MERGE_BLOCK_SIZE);
+		}
+		/* the winner moves on to its next key, fetching its next block if needed */
+		if(++positions[w] == blocks[w].size()) {
+			positions[w] = 0;
+			live[w] = readers[w]->next(blocks[w]);
+		}
+		if(live[w])
+			heads[w] = blocks[w][positions[w]];
+		tree.replay();
+	}
+	if(!out.empty())
+		writer.write(out);
+	writer.finish();
+	return tree.comparisons();
+}
+
+external_sort_stats external_merge_sort(const std::string &infile, const std::string &outfile, size_t memory) {
+	external_sort_stats stats = {0, 0, 0, 0, 0};
+	struct stat st;
+	int in_fd = open(infile.c_str(), O_RDONLY);
+	if(in_fd < 0 || fstat(in_fd, &st) != 0) {
+		std::ostringstream oss;
+		oss << infile << ": " << std::strerror(errno);
+		if(in_fd >= 0)
+			close(in_fd);
+		throw std::runtime_error(oss.str());
+	}
+	if(st.st_size % sizeof(std::uint64_t) != 0) {
+		std::ostringstream oss;
+		oss << infile << ": not a file of 64-bit keys";
+		close(in_fd);
+		throw std::runtime_error(oss.str());
+	}
+
+	/* outfile is only truncated once it is known not to be infile */
+	struct stat out_st;
+	int out_fd = open(outfile.c_str(), O_WRONLY | O_CREAT, 0644);
+	if(out_fd < 0 || fstat(out_fd, &out_st) != 0) {
+		std::ostringstream oss;
+		oss << outfile << ": " << std::strerror(errno);
+		close(in_fd);
+		if(out_fd >= 0)
+			close(out_fd);
+		throw std::runtime_error(oss.str());
+	}
+	if(out_st.st_dev == st.st_dev && out_st.st_ino == st.st_ino) {
+		std::ostringstream oss;
+		oss << outfile << ": the output file is the input file";
+		close(in_fd);
+		close(out_fd);
+		throw std::runtime_error(oss.str());
+	}
+	if(ftruncate(out_fd, 0) != 0) {
+		std::ostringstream oss;
+		oss << outfile << ": " << std::strerror(errno);
+		close(in_fd);
+		close(out_fd);
+		throw std::runtime_error(oss.str());
+	}
+	int fds[2] = {-1, -1};
+	auto close_all = [&]() {
+		close(in_fd);
+		close(out_fd);
+		for(int fd : fds) {
+			if(fd >= 0)
+				close(fd);
+		}
+	};
+
+	try {
+		stats.n_keys = st.st_size / sizeof(std::uint64_t);
+
+		/* a run is held by the reader, merge_sort and the writer, each with a spare buffer */
+		size_t run_size = std::max<size_t>(MERGE_BLOCK_SIZE, memory / (6 * sizeof(std::uint64_t)));
+		/* each run being merged has a reader holding three blocks and the writer takes the
+		 * room of one more; a budget too small for that still merges two runs at a time */
+		size_t n_readers = memory / (3 * MERGE_BLOCK_SIZE * sizeof(std::uint64_t));
+		size_t fan_in = std::max<size_t>(2, n_readers > 1 ? n_readers - 1 : 0);
+		std::vector<sorted_run> runs, merged;
+		if(stats.n_keys <= run_size) {
+			stats.run_comparisons = form_runs(in_fd, infile, stats.n_keys, run_size, out_fd, outfile, runs);
+			stats.n_runs = runs.size();
+			close_all();
+			return stats;
+		}
+
+		/* the temporary files are unlinked right away, so they go away with the process */
+		for(int &fd : fds) {
+			const char *tmpdir = std::getenv("TMPDIR");
+			std::string filename = std::string(tmpdir ? tmpdir : "/tmp") + "/unmerge-runs-XXXXXX";
+			fd = mkstemp(&filename[0]);
+			if(fd < 0) {
+				std::ostringstream oss;
+				oss << filename << ": " << std::strerror(errno);
+				throw std::runtime_error(oss.str());
+			}
+			unlink(filename.c_str());
+		}
+		stats.run_comparisons = form_runs(in_fd, infile, stats.n_keys, run_size, fds[0], "runs", runs);
+		stats.n_runs = runs.size();
+
+		/* merges fan_in runs at a time until one pass can write all of them to outfile */
+		while(runs.size() > fan_in) {
+			std::uint64_t offset = 0;
+			merged.clear();
+			for(size_t first = 0; first < runs.size(); first += fan_in) {
+				size_t last = std::min(runs.size(), first + fan_in);
+				stats.merge_comparisons += merge_runs(fds[0], "runs", runs, first, last, fds[1], "runs", offset);
+				std::uint64_t n_keys = 0;
+				for(size_t i = first; i < last; i++) {
+					n_keys += runs[i].n_keys;
+				}
+				merged.push_back(sorted_run{offset, n_keys});
+				offset += n_keys * sizeof(std::uint64_t);
+			}
+			runs.swap(merged);
+			std::swap(fds[0], fds[1]);
+			stats.n_passes++;
+		}
+		stats.merge_comparisons += merge_runs(fds[0], "runs", runs, 0, runs.size(), out_fd, outfile, 0);
+		stats.n_passes++;
+	}
+	catch (...) {
+		close_all();
+		throw;
+	}
+	close_all();
+	return stats;
+}
+
 void usage(char *name) {
 	std::cout << "usage: ";
-	std::cout << name << " [n_items]" << std::endl;
+	std::cout << name << " [--engine=classic|buffered|parallel|generic|kernel] [--threads=n]" << std::endl;
+	std::cout << "       " << std::string(std::strlen(name), ' ') << " [--kernel=scalar|branchless|avx2] [--base=n] [--unmerge=classic|direct] [n_items]" << std::endl;
+	std::cout << "  --engine - merge sort engine; buffered sorts with a single buffer (default: buffered)" << std::endl;
+	std::cout << "  --kernel - merge kernel of the kernel engine (default: avx2)" << std::endl;
+	std::cout << "  --base - largest subarray the kernel engine sorts with insertion sort (default: 16)" << std::endl;
+	std::cout << "  --threads - number of threads the parallel engine uses; 0 uses every core (default: 0)" << std::endl;
+	std::cout << "  --unmerge - unmerge sort engine; direct fills the array in one pass (default: direct)" << std::endl;
+	std::cout << "       " << name << " --generate [--format=text|binary] [--shard=i/k] [--threads=n] [--output=file] n_items" << std::endl;
+	std::cout << "  --generate - stream the worst-case input of n_items items instead of sorting it" << std::endl;
+	std::cout << "  --format - text writes an item per line, binary 64-bit integers (default: text)" << std::endl;
+	std::cout << "  --shard - write only the i-th of k equal slices of the input, from 0 (default: 0/1)" << std::endl;
+	std::cout << "       " << name << " --external=infile --output=outfile [--memory=bytes]" << std::endl;
+	std::cout << "  --external - sort the binary 64-bit keys in infile into outfile, using disk for" << std::endl;
+	std::cout << "               what does not fit in memory" << std::endl;
+	std::cout << "  --memory - memory budget of the external sort in bytes (default: 268435456)" << std::endl;
+	std::cout << "  --output - file to write the input or sorted keys to (default: standard output)" << std::endl;
 	std::cout << "  n_items - integer specifying the number of items to generate" << std::endl;
 }
 
 int main (int argc, char *argv[]) {
 	int n_items;
+	merge_engine engine = MERGE_BUFFERED;
+	unsigned n_threads = std::max(1u, std::thread::hardware_concurrency());
+	unmerge_engine unmerge = UNMERGE_DIRECT;
+	merge_kernel kernel = KERNEL_AVX2;
+	size_t base_size = DEFAULT_BASE_SIZE;
+	bool generate = false;
+	output_format format = FORMAT_TEXT;
+	unsigned long long shard = 0, n_shards = 1;
+	std::string output_file;
+	std::string external_file;
+	size_t memory = DEFAULT_EXTERNAL_MEMORY;
+	std::vector<std::string> args;
 
-	if(argc != 2) {
+	// separates the options from the positional arguments
+	for(int i = 1; i < argc; i++) {
+		std::string arg(argv[i]);
+		if(arg.compare(0, 9, "--engine=") == 0) {
+			try {
+				engine = parse_merge_engine(arg.substr(9));
+			}
+			catch (std::exception &ex) {
+				std::cerr << ex.what() << std::endl << std::endl;
+				usage(argv[0]);
+				return -1;
+			}
+		}
+		else if(arg.compare(0, 10, "--threads=") == 0) {
+			int value;
+			std::istringstream iss(arg.substr(10));
+			if((iss >> value).fail() || !iss.eof() || value < 0) {
+				std::cerr << arg.substr(10) << " is not a valid number of threads." << std::endl << std::endl;
+				usage(argv[0]);
+				return -1;
+			}
+			n_threads = (value == 0) ? std::max(1u, std::thread::hardware_concurrency()) : (unsigned)value;
+		}
+		else if(arg.compare(0, 9, "--kernel=") == 0) {
+			try {
+				kernel = parse_merge_kernel(arg.substr(9));
+			}
+			catch (std::exception &ex) {
+				std::cerr << ex.what() << std::endl << std::endl;
+				usage(argv[0]);
+				return -1;
+			}
+		}
+		else if(arg.compare(0, 7, "--base=") == 0) {
+			int value;
+			std::istringstream iss(arg.substr(7));
+			if((iss >> value).fail() || !iss.eof() || value < 1) {
+				std::cerr << arg.substr(7) << " is not a valid base case size." << std::endl << std::endl;
+				usage(argv[0]);
+				return -1;
+			}
+			base_size = (size_t)value;
+		}
+		else if(arg == "--generate") {
+			generate = true;
+		}
+		else if(arg == "--format=text" || arg == "--format=binary") {
+			format = (arg == "--format=text") ? FORMAT_TEXT : FORMAT_BINARY;
+		}
+		else if(arg.compare(0, 8, "--shard=") == 0) {
+			char slash;
+			std::istringstream iss(arg.substr(8));
+			if((iss >> shard >> slash >> n_shards).fail() || !iss.eof() || slash != '/' || shard >= n_shards) {
+				std::cerr << arg.substr(8) << " is not a valid shard." << std::endl << std::endl;
+				usage(argv[0]);
+				return -1;
+			}
+		}
+		else if(arg.compare(0, 11, "--external=") == 0) {
+			external_file = arg.substr(11);
+		}
+		else if(arg.compare(0, 9, "--memory=") == 0) {
+			long long value;
+			std::istringstream iss(arg.substr(9));
+			if((iss >> value).fail() || !iss.eof() || value < 1) {
+				std::cerr << arg.substr(9) << " is not a valid memory size." << std::endl << std::endl;
+				usage(argv[0]);
+				return -1;
+			}
+			memory = (size_t)value;
+		}
+		else if(arg.compare(0, 9, "--output=") == 0) {
+			output_file = arg.substr(9);
+		}
+		else if(arg.compare(0, 10, "--unmerge=") == 0) {
+			try {
+				unmerge = parse_unmerge_engine(arg.substr(10));
+			}
+			catch (std::exception &ex) {
+				std::cerr << ex.what() << std::endl << std::endl;
+				usage(argv[0]);
+				return -1;
+			}
+		}
+		else {
+			args.push_back(arg);
+		}
+	}
+
+	if(!external_file.empty()) {
+		if(!args.empty() || output_file.empty()) {
+			std::cerr << "Invalid number of arguments." << std::endl << std::endl;
+			usage(argv[0]);
+			return -1;
+		}
+		try {
+			external_sort_stats stats = external_merge_sort(external_file, output_file, memory);
+			std::cout << "Sorted " << stats.n_keys << " key(s) in " << stats.n_runs << " run(s) and "
+				<< stats.n_passes << " merge pass(es)" << std::endl;
+			std::cout << stats.run_comparisons << " comparison(s) sorting the runs and "
+				<< stats.merge_comparisons << " merging them" << std::endl;
+			std::cout << stats.run_comparisons + stats.merge_comparisons << " comparison(s) required to sort" << std::endl;
+		}
+		catch (std::exception &ex) {
+			std::cerr << ex.what() << std::endl;
+			return -1;
+		}
+		return 0;
+	}
+
+	if(args.size() != 1) {
 		std::cerr << "Invalid number of arguments." << std::endl << std::endl;
 		usage(argv[0]);
 		return -1;
 	}
+
+	if(generate) {
+		unsigned long long n_total;
+		std::istringstream iss(args[0]);
+		/* operator>> would wrap "-5" around to 2^64-5 */
+		if(args[0].empty() || args[0].find_first_not_of("0123456789") != std::string::npos
+			|| (iss >> n_total).fail() || !iss.eof()) {
+			std::cerr << args[0] << " is not a valid integer." << std::endl << std::endl;
+			usage(argv[0]);
+			return -1;
+		}
+		if(n_total > std::numeric_limits<size_t>::max()) {
+			std::cerr << args[0] << " is too many items to index." << std::endl << std::endl;
+			usage(argv[0]);
+			return -1;
+		}
+
+		int fd = 1;
+		std::string filename = output_file.empty() ? "stdout" : output_file;
+		if(!output_file.empty() && (fd = open(output_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+			std::cerr << output_file << ": " << std::strerror(errno) << std::endl;
+			return -1;
+		}
+		try {
+			/* the k shards tile [0,n) without gaps or overlaps */
+			size_t first = (size_t)((unsigned __int128)n_total * shard / n_shards);
+			size_t last = (size_t)((unsigned __int128)n_total * (shard + 1) / n_shards);
+			generate_unmerged(fd, filename, n_total, first, last, format, n_threads);
+		}
+		catch (std::exception &ex) {
+			std::cerr << ex.what() << std::endl;
+			return -1;
+		}
+		if(fd != 1 && close(fd) != 0) {
+			std::cerr << output_file << ": " << std::strerror(errno) << std::endl;
+			return -1;
+		}
+		return 0;
+	}
 	
-	std::istringstream iss(argv[1]);
+	std::istringstream iss(args[0]);
 	if((iss>>n_items).fail() || !iss.eof()) {
-		std::cerr << argv[1] << " is not a valid integer." << std::endl << std::endl;
+		std::cerr << args[0] << " is not a valid integer." << std::endl << std::endl;
 		usage(argv[0]);
 
 		return -1;
@@ -228,9 +2098,25 @@ int main (int argc, char *argv[]) {
 
 	std::vector<int> items(n_items);
 	std::iota(items.begin(), items.end(), 0);
-	unmerge_sort(items);
+	if(unmerge == UNMERGE_CLASSIC)
+		unmerge_sort(items);
+	else
+		direct_unmerge_sort(items);
 	std::cout << items << std::endl;
-	size_t n_comparisons = merge_sort(items);
+	size_t n_comparisons;
+	if(engine == MERGE_CLASSIC)
+		n_comparisons = merge_sort(items);
+	else if(engine == MERGE_BUFFERED)
+		n_comparisons = buffered_merge_sort(items);
+	else if(engine == MERGE_PARALLEL)
+		n_comparisons = parallel_merge_sort(items, n_threads);
+	else if(engine == MERGE_GENERIC)
+		n_comparisons = merge_sort<comparison_counter>(items.begin(), items.end()).count;
+	else {
+		merge_counts counts = kernel_merge_sort(items, kernel, base_size);
+		n_comparisons = counts.logical;
+		std::cout << counts.actual << " comparison(s) made by the kernel" << std::endl;
+	}
 	std::cout << n_comparisons << " comparison(s) required to sort" << std::endl;
 
 	return 0;